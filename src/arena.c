@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "histogram.h"
+#include "mnk.h"
+#include "pool.h"
+#include "precache.h"
+#include "scan.h"
+#include "util.h"
+
+/* Seed of the bots' random moves, so that every build plays the same games
+ * when the arena runs on one thread */
+#define ARENA_SEED 12345
+
+#define DEFAULT_GAMES 100
+
+/* Games a worker plays side by side, so that every round of moves is checked
+ * for wins with one scan_boards call */
+#define ARENA_LANES 16
+
+typedef struct arena_job_t arena_job;
+typedef struct pairing_t pairing;
+
+/* A worker's share of the games of one pairing. Each worker plays its games
+ * ARENA_LANES at a time */
+struct arena_job_t
+{
+    int bots[2];
+    int first_game;
+    int num_games;
+    int stride;
+    int results[3];
+    histogram latencies;
+};
+
+/* The totals of every game between one pair of bots */
+struct pairing_t
+{
+    int bots[2];
+    int games;
+    int results[3];
+    long long elapsed_ns;
+    histogram *latencies;
+};
+
+/* Plays a worker's share of the games of a pairing, timing every move. The
+ * first player alternates between games so that neither bot always starts.
+ * The games of a group all start together and each moves once per round, so
+ * they are always on the same turn. The bots are called on bare boards
+ * rather than through a game and play_turn, so only their moves are timed */
+static void
+run_arena_job(void *arg)
+{
+    arena_job *job = arg;
+    int n, i, turn, pos, player, bot, num_lanes;
+    int x_bots[ARENA_LANES];
+    int8_t statuses[ARENA_LANES];
+    uint16_t legal_moves[ARENA_LANES];
+    board_t boards[ARENA_LANES];
+    long long start;
+
+    for (n = 0; n < job->num_games; n += num_lanes) {
+        num_lanes = job->num_games - n < ARENA_LANES ? job->num_games - n
+                                                     : ARENA_LANES;
+
+        for (i = 0; i < num_lanes; i++) {
+            x_bots[i] = (job->first_game + (n + i) * job->stride) % 2;
+            board_clear(&boards[i]);
+            statuses[i] = -1;
+        } /* for */
+
+        for (turn = 1; turn <= 9; turn++) {
+            player = turn % 2 == 1 ? 1 : 2;
+
+            for (i = 0; i < num_lanes; i++) {
+                if (statuses[i] != -1) { continue; }
+
+                bot = job->bots[player == 1 ? x_bots[i] : !x_bots[i]];
+                start = now_ns();
+                pos = bot_move_funcs[bot](&boards[i], player);
+                board_place(&boards[i], pos, player);
+                hist_record(&job->latencies, now_ns() - start);
+            } /* for */
+
+            /* Can only win after the 5th turn, hence the check */
+            if (turn >= 5) {
+                scan_boards(boards, num_lanes, statuses, legal_moves);
+            } /* if */
+        } /* for */
+
+        /* Results are counted from the first bot of the pairing's side */
+        for (i = 0; i < num_lanes; i++) {
+            if (statuses[i] == 0) { job->results[0]++; }
+            else if ((statuses[i] == 1) == (x_bots[i] == 0)) {
+                job->results[1]++;
+            } /* else if */
+            else { job->results[2]++; }
+        } /* for */
+    } /* for */
+}
+
+/* Plays every game of a pairing, spread over the pool */
+static void
+run_pairing(pool_t *pool, int num_workers, pairing *pair)
+{
+    int w, i;
+    long long start;
+    pool_group group = { 0 };
+    arena_job *jobs = calloc(num_workers, sizeof(arena_job));
+
+    pair->latencies = malloc(sizeof(histogram));
+    hist_init(pair->latencies);
+    memset(pair->results, 0, sizeof(pair->results));
+
+    start = now_ns();
+    for (w = 0; w < num_workers; w++) {
+        jobs[w].bots[0] = pair->bots[0];
+        jobs[w].bots[1] = pair->bots[1];
+        jobs[w].first_game = w;
+        jobs[w].stride = num_workers;
+        jobs[w].num_games = (pair->games - w + num_workers - 1) / num_workers;
+        hist_init(&jobs[w].latencies);
+        pool_submit(pool, &group, run_arena_job, &jobs[w]);
+    } /* for */
+    pool_wait(pool, &group);
+    pair->elapsed_ns = now_ns() - start;
+
+    for (w = 0; w < num_workers; w++) {
+        for (i = 0; i < 3; i++) { pair->results[i] += jobs[w].results[i]; }
+        hist_merge(pair->latencies, &jobs[w].latencies);
+    } /* for */
+
+    free(jobs);
+}
+
+/* Prints the JSON object for one pairing */
+static void
+print_pairing(const pairing *pair, bool last)
+{
+    printf("    {\n");
+    printf("      \"bot\": \"%s\",\n", bot_names[pair->bots[0]]);
+    printf("      \"opponent\": \"%s\",\n", bot_names[pair->bots[1]]);
+    printf("      \"games\": %d,\n", pair->games);
+    printf("      \"wins\": %d,\n", pair->results[1]);
+    printf("      \"losses\": %d,\n", pair->results[2]);
+    printf("      \"draws\": %d,\n", pair->results[0]);
+    printf("      \"games_per_sec\": %.1f,\n",
+           pair->elapsed_ns > 0 ? pair->games * 1e9 / pair->elapsed_ns : 0.0);
+    printf("      \"moves\": %llu,\n",
+           (unsigned long long)pair->latencies->total);
+    printf("      \"move_ns_p50\": %llu,\n",
+           (unsigned long long)hist_percentile(pair->latencies, 50));
+    printf("      \"move_ns_p90\": %llu,\n",
+           (unsigned long long)hist_percentile(pair->latencies, 90));
+    printf("      \"move_ns_p99\": %llu,\n",
+           (unsigned long long)hist_percentile(pair->latencies, 99));
+    printf("      \"move_ns_max\": %llu\n",
+           (unsigned long long)pair->latencies->max);
+    printf("    }%s\n", last ? "" : ",");
+}
+
+/* Prints the command-line options */
+static void
+usage(const char *prog)
+{
+    int i;
+
+    fprintf(stderr, "Usage: %s [--games N] [--threads N] [--bot NAME] "
+            "[--opponent NAME]\n", prog);
+    fprintf(stderr, "  --games N        Games per pairing (default %d)\n",
+            DEFAULT_GAMES);
+    fprintf(stderr, "  --threads N      Games played at once (default: one "
+            "per core)\n");
+    fprintf(stderr, "  --bot NAME       Only pair this bot (default: every "
+            "bot)\n");
+    fprintf(stderr, "  --opponent NAME  Only against this bot (default: every "
+            "bot)\n");
+    fprintf(stderr, "Bots:");
+    for (i = 0; i < NUM_BOTS; i++) { fprintf(stderr, " %s", bot_names[i]); }
+    fprintf(stderr, "\n");
+}
+
+/* Plays bots against each other headlessly and prints the results as JSON */
+int
+main(int argc, char **argv)
+{
+    int i, a, b, num_pairings;
+    int games = DEFAULT_GAMES, bot = -1, opponent = -1;
+    int num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    long long start, elapsed_ns, total_games = 0;
+    pool_t *pool;
+    pairing pairings[NUM_BOTS * NUM_BOTS];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } /* if */
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_workers = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--bot") == 0 && i + 1 < argc) {
+            bot = find_bot(argv[++i]);
+            if (bot == -1) {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+        } /* else if */
+        else if (strcmp(argv[i], "--opponent") == 0 && i + 1 < argc) {
+            opponent = find_bot(argv[++i]);
+            if (opponent == -1) {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+        } /* else if */
+        else {
+            usage(argv[0]);
+            return 1;
+        } /* else */
+    } /* for */
+
+    if (games < 1) { games = 1; }
+    if (num_workers < 1) { num_workers = 1; }
+
+    precache_load(PRECACHE_PATH);
+    init_caches();
+    pool = pool_create(num_workers);
+    if (pool == NULL) {
+        fprintf(stderr, "Could not start %d workers\n", num_workers);
+        return 1;
+    } /* if */
+
+    num_pairings = 0;
+    for (a = 0; a < NUM_BOTS; a++) {
+        for (b = 0; b < NUM_BOTS; b++) {
+            if ((bot != -1 && a != bot) || (opponent != -1 && b != opponent)) {
+                continue;
+            } /* if */
+            pairings[num_pairings].bots[0] = a;
+            pairings[num_pairings].bots[1] = b;
+            pairings[num_pairings++].games = games;
+        } /* for */
+    } /* for */
+
+    printf("{\n");
+    printf("  \"games_per_pairing\": %d,\n", games);
+    printf("  \"threads\": %d,\n", num_workers);
+    printf("  \"pairings\": [\n");
+
+    start = now_ns();
+    for (i = 0; i < num_pairings; i++) {
+        /* Every pairing starts on empty caches, so that its results do not
+         * depend on the pairings played before it */
+        reset_caches();
+        mnk_reset_cache();
+        srand(ARENA_SEED + i);
+        run_pairing(pool, num_workers, &pairings[i]);
+        print_pairing(&pairings[i], i == num_pairings - 1);
+        total_games += pairings[i].games;
+        free(pairings[i].latencies);
+    } /* for */
+    elapsed_ns = now_ns() - start;
+
+    printf("  ],\n");
+    printf("  \"games\": %lld,\n", total_games);
+    printf("  \"seconds\": %.3f,\n", elapsed_ns / 1e9);
+    printf("  \"games_per_sec\": %.1f\n",
+           elapsed_ns > 0 ? total_games * 1e9 / elapsed_ns : 0.0);
+    printf("}\n");
+
+    pool_destroy(pool);
+    free_caches();
+    mnk_free_cache();
+    precache_unload();
+
+    return 0;
+}
+/* EOF */
@@ -0,0 +1,188 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "pool.h"
+#include "precache.h"
+#include "scan.h"
+
+/* Boards scanned at a time, small enough for the results to stay on the
+ * stack */
+#define BATCH_SCAN 256
+
+typedef struct batch_job_t batch_job;
+
+/* A slice of a batch handed to a pool worker. Only one of keys and boards
+ * is set */
+struct batch_job_t
+{
+    const uint16_t *table;
+    const uint32_t *keys;
+    const board_t *boards;
+    size_t count;
+    int8_t *outcomes;
+    uint16_t *best_moves;
+    size_t invalid;
+};
+
+/* The base-3 key of each mask with its squares set to 1, so that a board's
+ * key is base3_masks[X mask] + 2 * base3_masks[O mask] */
+static uint16_t base3_masks[FULL_BOARD + 1];
+static pthread_once_t base3_once = PTHREAD_ONCE_INIT;
+
+/* Fills in base3_masks */
+static void
+init_base3_masks(void)
+{
+    int mask, i;
+
+    for (mask = 0; mask <= FULL_BOARD; mask++) {
+        for (i = 8; i >= 0; i--) {
+            base3_masks[mask] = base3_masks[mask] * 3 + (mask >> i & 1);
+        } /* for */
+    } /* for */
+}
+
+/* Evaluates a slice of a batch of keys. The loop has no branches, so the
+ * compiler is free to vectorize it: an out of range key reads as an
+ * unreachable entry, which is 0 */
+static size_t
+evaluate_keys(const uint16_t *table, const uint32_t *keys, size_t count,
+              int8_t *outcomes, uint16_t *best_moves)
+{
+    size_t i, invalid = 0;
+    uint32_t key;
+    uint16_t entry;
+
+    for (i = 0; i < count; i++) {
+        key = keys[i] < PRECACHE_ENTRIES ? keys[i] : 0;
+        entry = keys[i] < PRECACHE_ENTRIES ? table[key] : 0;
+        outcomes[i] = (int8_t)((entry >> PRECACHE_OUTCOME_SHIFT & 3) - 1);
+        best_moves[i] = entry & PRECACHE_MOVES_MASK;
+        invalid += entry == OUTCOME_UNREACHABLE;
+    } /* for */
+
+    return invalid;
+}
+
+/* Evaluates a slice of a batch of boards. Finished boards take the status
+ * of the scan. A board is invalid if it has both marks on a square or the
+ * table has no entry for it, which also catches finished boards no game
+ * reaches, such as a line of X with no O or a line for each player */
+static size_t
+evaluate_boards(const uint16_t *table, const board_t *boards, size_t count,
+                int8_t *outcomes, uint16_t *best_moves)
+{
+    size_t i, j, n, invalid = 0;
+    int8_t statuses[BATCH_SCAN];
+    uint16_t legal_moves[BATCH_SCAN];
+    uint16_t x, o, entry;
+    bool valid;
+
+    for (i = 0; i < count; i += n) {
+        n = count - i < BATCH_SCAN ? count - i : BATCH_SCAN;
+        scan_boards(boards + i, n, statuses, legal_moves);
+
+        for (j = 0; j < n; j++) {
+            x = boards[i + j].masks[0] & FULL_BOARD;
+            o = boards[i + j].masks[1] & FULL_BOARD;
+            /* Clearing the overlap keeps the key in range */
+            entry = table[base3_masks[x] + 2 * base3_masks[o & ~x]];
+            valid = (x & o) == 0 && entry != OUTCOME_UNREACHABLE;
+
+            if (!valid) { outcomes[i + j] = -1; }
+            else if (statuses[j] != -1) { outcomes[i + j] = statuses[j]; }
+            else {
+                outcomes[i + j] = (entry >> PRECACHE_OUTCOME_SHIFT & 3) - 1;
+            } /* else */
+
+            /* The legal moves are empty once the game is over */
+            best_moves[i + j] = valid ? entry & legal_moves[j] : 0;
+            invalid += !valid;
+        } /* for */
+    } /* for */
+
+    return invalid;
+}
+
+/* Evaluates one job's slice on a worker thread */
+static void
+run_batch_job(void *arg)
+{
+    batch_job *job = arg;
+
+    if (job->boards != NULL) {
+        job->invalid = evaluate_boards(job->table, job->boards, job->count,
+                                       job->outcomes, job->best_moves);
+    } /* if */
+    else {
+        job->invalid = evaluate_keys(job->table, job->keys, job->count,
+                                     job->outcomes, job->best_moves);
+    } /* else */
+}
+
+/* Evaluates a batch of keys or boards, split across the search pool if it is
+ * big enough */
+static size_t
+evaluate_batch(const uint32_t *keys, const board_t *boards, size_t count,
+               int8_t *outcomes, uint16_t *best_moves)
+{
+    size_t i, num_jobs, invalid = 0;
+    const uint16_t *table = precache_get_table();
+    pool_t *pool = count > BATCH_CHUNK ? search_pool() : NULL;
+    pool_group group = { 0 };
+    batch_job *jobs;
+
+    /* Without a table, every position is invalid */
+    if (table == NULL) {
+        memset(outcomes, -1, count);
+        memset(best_moves, 0, sizeof(uint16_t) * count);
+        return count;
+    } /* if */
+
+    num_jobs = pool == NULL ? 1 : (count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    jobs = malloc(sizeof(batch_job) * num_jobs);
+
+    for (i = 0; i < num_jobs; i++) {
+        jobs[i].table = table;
+        jobs[i].keys = keys != NULL ? keys + i * BATCH_CHUNK : NULL;
+        jobs[i].boards = boards != NULL ? boards + i * BATCH_CHUNK : NULL;
+        jobs[i].count = i == num_jobs - 1 ? count - i * BATCH_CHUNK
+                                          : BATCH_CHUNK;
+        jobs[i].outcomes = outcomes + i * BATCH_CHUNK;
+        jobs[i].best_moves = best_moves + i * BATCH_CHUNK;
+    } /* for */
+
+    if (pool == NULL) { run_batch_job(&jobs[0]); }
+    else {
+        for (i = 0; i < num_jobs; i++) {
+            pool_submit(pool, &group, run_batch_job, &jobs[i]);
+        } /* for */
+        pool_wait(pool, &group);
+    } /* else */
+
+    for (i = 0; i < num_jobs; i++) { invalid += jobs[i].invalid; }
+    free(jobs);
+
+    return invalid;
+}
+
+/* Evaluates many 3x3 positions under perfect play in one call */
+size_t
+batch_evaluate(const uint32_t *keys, size_t count, int8_t *outcomes,
+               uint16_t *best_moves)
+{
+    return evaluate_batch(keys, NULL, count, outcomes, best_moves);
+}
+
+/* Evaluates many 3x3 boards under perfect play in one call */
+size_t
+batch_evaluate_boards(const board_t *boards, size_t count, int8_t *outcomes,
+                      uint16_t *best_moves)
+{
+    pthread_once(&base3_once, init_base3_masks);
+
+    return evaluate_batch(NULL, boards, count, outcomes, best_moves);
+}
+/* EOF */
@@ -0,0 +1,53 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util.h"
+
+/* Positions each pool job evaluates. Smaller batches stay on the calling
+ * thread, since a job costs more than looking them up */
+#define BATCH_CHUNK 65536
+
+/**
+ * Evaluates many 3x3 positions under perfect play in one call. Each position
+ * is a board_key (square i is base-3 digit i: 0 empty, 1 X, 2 O), and the
+ * player to move follows from the marks on the board since X moves first.
+ * The answers come from the solved precache table, which is fetched once for
+ * the whole batch, and large batches are split across the search pool
+ * @param keys The encoded positions
+ * @param count The number of positions
+ * @param outcomes The result of each position under perfect play: 0 for a
+ * tie, 1/2 if player 1/2 wins, or -1 if the position cannot come up in a game
+ * or the key is out of range. Passed in as an out value
+ * @param best_moves The set of best moves of each position for the player to
+ * move, bit i for square i: the fastest wins, else ties, else the slowest
+ * losses. 0 if the game is over or the position is invalid. Passed in as an
+ * out value
+ * @return The number of invalid positions, which is all of them if there is
+ * no memory to solve the precache table in
+ */
+size_t batch_evaluate(const uint32_t *keys, size_t count, int8_t *outcomes,
+                      uint16_t *best_moves);
+
+/**
+ * Evaluates many 3x3 boards under perfect play in one call, like
+ * batch_evaluate but without encoding the boards first. The boards are
+ * scanned for finished games with scan_boards, which answers those from
+ * their lines alone, and the rest are looked up in the precache table. A
+ * board that is invalid as a key, including a finished board no game
+ * reaches, is invalid here too
+ * @param boards The tic-tac-toe boards
+ * @param count The number of boards
+ * @param outcomes The result of each board under perfect play, as in
+ * batch_evaluate. Passed in as an out value
+ * @param best_moves The set of best moves of each board, as in
+ * batch_evaluate. Passed in as an out value
+ * @return The number of invalid boards
+ */
+size_t batch_evaluate_boards(const board_t *boards, size_t count,
+                             int8_t *outcomes, uint16_t *best_moves);
+
+#endif
+/* EOF */
@@ -0,0 +1,523 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "batch.h"
+#include "mnk.h"
+#include "order.h"
+#include "pool.h"
+#include "precache.h"
+#include "scan.h"
+#include "stats.h"
+#include "util.h"
+
+/* Seed of the random midgames, so that every build benches the same boards */
+#define BENCH_SEED 12345
+
+#define NUM_MIDGAMES 20
+#define MAX_POSITIONS (1 + 9 + NUM_MIDGAMES)
+
+/* Random openings searched on each bigger board */
+#define NUM_MNK_OPENINGS 5
+
+typedef struct position_t position;
+typedef struct mnk_config_t mnk_config;
+
+struct position_t
+{
+    board_t board;
+    int player;
+};
+
+/* A bigger board searched to a fixed depth by the m,n,k engine */
+struct mnk_config_t
+{
+    int width;
+    int height;
+    int k;
+    int depth;
+};
+
+static const mnk_config mnk_configs[] = {
+    { 4, 4, 3, 16 },
+    { 7, 7, 4, 6 },
+    { 9, 9, 5, 5 },
+    { 15, 15, 5, 4 }
+};
+
+#define NUM_MNK_CONFIGS (int)(sizeof(mnk_configs) / sizeof(mnk_configs[0]))
+
+/* Gets the peak resident set size of the process in kilobytes */
+static long
+peak_rss_kb(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+/* Fills in the benched boards: the empty board, every opening move and a set
+ * of random, unfinished midgames */
+static int
+make_positions(position *positions)
+{
+    int i, ply, num_plies, num_empty;
+    int num_positions = 0;
+    int legal_moves[9];
+    board_t board;
+
+    board_clear(&positions[num_positions].board);
+    positions[num_positions++].player = 1;
+
+    for (i = 0; i < 9; i++) {
+        board_clear(&positions[num_positions].board);
+        board_place(&positions[num_positions].board, i, 1);
+        positions[num_positions++].player = 2;
+    } /* for */
+
+    srand(BENCH_SEED);
+
+    while (num_positions < MAX_POSITIONS) {
+        board_clear(&board);
+        num_plies = 2 + rand() % 5;
+
+        for (ply = 0; ply < num_plies; ply++) {
+            num_empty = get_legal_moves(&board, legal_moves);
+            board_place(&board, legal_moves[rand() % num_empty], ply % 2 + 1);
+        } /* for */
+
+        if (check_for_win(&board) != -1) { continue; }
+
+        positions[num_positions].board = board;
+        positions[num_positions++].player = num_plies % 2 + 1;
+    } /* while */
+
+    return num_positions;
+}
+
+/* Prints the JSON object comparing the batch calls over every board against
+ * handling the boards one call at a time: batch_evaluate against
+ * precache_lookup, batch_evaluate_boards on the boards themselves, and
+ * scan_boards against check_for_win with get_legal_moves */
+static void
+bench_batch(int reps)
+{
+    int i, rep, sq;
+    uint32_t key;
+    int num_mismatches = 0, legal_moves[9];
+    long long start, batch_ns = 0, boards_ns = 0, single_ns = 0;
+    long long scan_ns = 0, single_scan_ns = 0;
+    long long num_positions = (long long)PRECACHE_ENTRIES * reps;
+    size_t invalid = 0;
+    uint32_t *keys = malloc(sizeof(uint32_t) * PRECACHE_ENTRIES);
+    board_t *boards = malloc(sizeof(board_t) * PRECACHE_ENTRIES);
+    int8_t *outcomes = malloc(PRECACHE_ENTRIES);
+    int8_t *board_outcomes = malloc(PRECACHE_ENTRIES);
+    int8_t *statuses = malloc(PRECACHE_ENTRIES);
+    int8_t *single_statuses = malloc(PRECACHE_ENTRIES);
+    uint16_t *best_moves = malloc(sizeof(uint16_t) * PRECACHE_ENTRIES);
+    uint16_t *board_best_moves = malloc(sizeof(uint16_t) * PRECACHE_ENTRIES);
+    uint16_t *legal = malloc(sizeof(uint16_t) * PRECACHE_ENTRIES);
+    uint16_t *entries = malloc(sizeof(uint16_t) * PRECACHE_ENTRIES);
+
+    for (i = 0; i < PRECACHE_ENTRIES; i++) {
+        keys[i] = i;
+        board_clear(&boards[i]);
+
+        for (sq = 0, key = i; sq < 9; sq++, key /= 3) {
+            if (key % 3 != 0) { board_place(&boards[i], sq, key % 3); }
+        } /* for */
+    } /* for */
+
+    /* Solves the table before timing any path */
+    precache_get_table();
+
+    for (rep = 0; rep < reps; rep++) {
+        start = now_ns();
+        invalid = batch_evaluate(keys, PRECACHE_ENTRIES, outcomes,
+                                 best_moves);
+        batch_ns += now_ns() - start;
+
+        start = now_ns();
+        batch_evaluate_boards(boards, PRECACHE_ENTRIES, board_outcomes,
+                              board_best_moves);
+        boards_ns += now_ns() - start;
+
+        start = now_ns();
+        for (i = 0; i < PRECACHE_ENTRIES; i++) {
+            entries[i] = precache_lookup(&boards[i]);
+        } /* for */
+        single_ns += now_ns() - start;
+
+        start = now_ns();
+        scan_boards(boards, PRECACHE_ENTRIES, statuses, legal);
+        scan_ns += now_ns() - start;
+
+        start = now_ns();
+        for (i = 0; i < PRECACHE_ENTRIES; i++) {
+            single_statuses[i] = check_for_win(&boards[i]);
+            if (single_statuses[i] == -1) {
+                get_legal_moves(&boards[i], legal_moves);
+            } /* if */
+        } /* for */
+        single_scan_ns += now_ns() - start;
+    } /* for */
+
+    /* Every path must give the same answers, and the scans must agree on the
+     * boards a game can reach */
+    for (i = 0; i < PRECACHE_ENTRIES; i++) {
+        if (outcomes[i] != precache_result(entries[i])
+            || best_moves[i] != (entries[i] & PRECACHE_MOVES_MASK)
+            || board_outcomes[i] != outcomes[i]
+            || board_best_moves[i] != best_moves[i]) {
+            num_mismatches++;
+        } /* if */
+        else if (entries[i] != OUTCOME_UNREACHABLE
+                 && (statuses[i] != single_statuses[i]
+                     || legal[i] != (statuses[i] == -1
+                                     ? board_empty(&boards[i]) : 0))) {
+            num_mismatches++;
+        } /* else if */
+    } /* for */
+
+    printf("  \"batch\": {\n");
+    printf("    \"positions\": %lld,\n", num_positions);
+    printf("    \"ns_per_position\": %.2f,\n",
+           (double)batch_ns / num_positions);
+    printf("    \"boards_ns_per_position\": %.2f,\n",
+           (double)boards_ns / num_positions);
+    printf("    \"single_ns_per_position\": %.2f,\n",
+           (double)single_ns / num_positions);
+    printf("    \"scan_kernel\": \"%s\",\n", scan_kernel());
+    printf("    \"scan_ns_per_board\": %.2f,\n",
+           (double)scan_ns / num_positions);
+    printf("    \"single_scan_ns_per_board\": %.2f,\n",
+           (double)single_scan_ns / num_positions);
+    printf("    \"invalid\": %zu,\n", invalid);
+    printf("    \"mismatches\": %d\n", num_mismatches);
+    printf("  },\n");
+
+    free(keys);
+    free(boards);
+    free(outcomes);
+    free(board_outcomes);
+    free(statuses);
+    free(single_statuses);
+    free(best_moves);
+    free(board_best_moves);
+    free(legal);
+    free(entries);
+}
+
+/* Prints the JSON object for one bot run over every position */
+static void
+bench_bot(int bot, const position *positions, int num_positions, int reps)
+{
+    int i, rep;
+    long long start, cold_ns = 0, total_ns = 0;
+    search_stats total = { 0 };
+    player_move_func move_func = bot_move_funcs[bot];
+
+    for (rep = 0; rep < reps; rep++) {
+        for (i = 0; i < num_positions; i++) {
+            stats_begin(&positions[i].board);
+            start = now_ns();
+            move_func(&positions[i].board, positions[i].player);
+            total_ns += now_ns() - start;
+            stats_add(&total, &stats);
+        } /* for */
+
+        /* The first pass runs on an empty cache */
+        if (rep == 0) { cold_ns = total_ns; }
+    } /* for */
+
+    printf("    {\n");
+    printf("      \"name\": \"%s\",\n", bot_names[bot]);
+    printf("      \"moves\": %d,\n", num_positions * reps);
+    printf("      \"ns_per_move\": %.1f,\n",
+           (double)total_ns / (num_positions * reps));
+    printf("      \"cold_ns_per_move\": %.1f,\n",
+           (double)cold_ns / num_positions);
+    printf("      \"nodes\": %llu,\n", total.nodes);
+    printf("      \"terminal_nodes\": %llu,\n", total.terminals);
+    printf("      \"nodes_per_sec\": %.0f,\n",
+           total_ns > 0 ? total.nodes * 1e9 / total_ns : 0.0);
+    printf("      \"cache_probes\": %llu,\n", total.probes);
+    printf("      \"cache_hits\": %llu,\n", total.hits);
+    printf("      \"cache_stores\": %llu,\n", total.stores);
+    printf("      \"cache_hit_ratio\": %.4f,\n",
+           total.probes > 0 ? (double)total.hits / total.probes : 0.0);
+    printf("      \"cutoffs\": %llu,\n", total.cutoffs);
+    printf("      \"max_depth\": %d,\n", total.max_depth);
+    printf("      \"peak_rss_kb\": %ld\n", peak_rss_kb());
+    printf("    }%s\n", bot == NUM_BOTS - 1 ? "" : ",");
+}
+
+/* Prints the size one search cache grew to */
+static void
+print_cache(const char *name, const ht_t *table, bool last)
+{
+    printf("    \"%s\": { \"slots\": %u, \"bytes\": %zu }%s\n", name,
+           ht_size(table), ht_memory(table), last ? "" : ",");
+}
+
+/* Plays a random opening of up to 4 marks near the center of the board */
+static void
+make_mnk_opening(mnk_board *board, const mnk_config *config)
+{
+    int i, x, y, pos;
+    int num_marks = rand() % 5;
+
+    mnk_init(board, config->width, config->height, config->k);
+
+    for (i = 0; i < num_marks; i++) {
+        x = config->width / 2 - 1 + rand() % 3;
+        y = config->height / 2 - 1 + rand() % 3;
+        pos = y * config->width + x;
+        if (mnk_get(board, pos) != 0) { continue; }
+        mnk_place(board, pos, board->num_marks % 2 + 1);
+    } /* for */
+}
+
+/* Prints the JSON object for the fixed-depth searches of one bigger board,
+ * each on an empty transposition table */
+static void
+bench_mnk(int c)
+{
+    int i, best_move;
+    long long start, total_ns = 0;
+    const mnk_config *config = &mnk_configs[c];
+    search_stats total = { 0 };
+    mnk_board board;
+
+    srand(BENCH_SEED);
+
+    for (i = 0; i < NUM_MNK_OPENINGS; i++) {
+        make_mnk_opening(&board, config);
+        mnk_reset_cache();
+        stats_reset();
+        start = now_ns();
+        mnk_search(&board, board.num_marks % 2 + 1, config->depth, &best_move);
+        total_ns += now_ns() - start;
+        stats_add(&total, &stats);
+    } /* for */
+
+    printf("    {\n");
+    printf("      \"board\": \"%dx%d k=%d\",\n", config->width,
+           config->height, config->k);
+    printf("      \"depth\": %d,\n", config->depth);
+    printf("      \"searches\": %d,\n", NUM_MNK_OPENINGS);
+    printf("      \"ms_per_search\": %.2f,\n",
+           total_ns / 1e6 / NUM_MNK_OPENINGS);
+    printf("      \"nodes\": %llu,\n", total.nodes);
+    printf("      \"cutoffs\": %llu\n", total.cutoffs);
+    printf("    }%s\n", c == NUM_MNK_CONFIGS - 1 ? "" : ",");
+}
+
+/* Checks batch_evaluate_boards against batch_evaluate on every pair of
+ * masks, including boards with both marks on a square and finished boards
+ * no game reaches, which must both come out invalid
+ * @return The number of boards the two disagree on */
+static int
+verify_batch(int *num_boards)
+{
+    int x, o, i;
+    int num_mismatches = 0;
+    int count = (FULL_BOARD + 1) * (FULL_BOARD + 1);
+    size_t board_invalid, key_invalid;
+    board_t *boards = malloc(sizeof(board_t) * count);
+    uint32_t *keys = malloc(sizeof(uint32_t) * count);
+    int8_t *outcomes = malloc(count);
+    int8_t *board_outcomes = malloc(count);
+    uint16_t *best_moves = malloc(sizeof(uint16_t) * count);
+    uint16_t *board_best_moves = malloc(sizeof(uint16_t) * count);
+
+    for (x = 0, i = 0; x <= FULL_BOARD; x++) {
+        for (o = 0; o <= FULL_BOARD; o++, i++) {
+            boards[i].masks[0] = x;
+            boards[i].masks[1] = o;
+            /* A board with an overlap has no key, so it gets one out of
+             * range */
+            keys[i] = (x & o) != 0 ? PRECACHE_ENTRIES : board_key(&boards[i]);
+        } /* for */
+    } /* for */
+
+    board_invalid = batch_evaluate_boards(boards, count, board_outcomes,
+                                          board_best_moves);
+    key_invalid = batch_evaluate(keys, count, outcomes, best_moves);
+
+    for (i = 0; i < count; i++) {
+        if (board_outcomes[i] != outcomes[i]
+         || board_best_moves[i] != best_moves[i]) {
+            num_mismatches++;
+        } /* if */
+    } /* for */
+    if (board_invalid != key_invalid) { num_mismatches++; }
+
+    *num_boards = count;
+
+    free(boards);
+    free(keys);
+    free(outcomes);
+    free(board_outcomes);
+    free(best_moves);
+    free(board_best_moves);
+
+    return num_mismatches;
+}
+
+/* Checks the alpha-beta search against plain minimax on the board and every
+ * board reachable from it. The cache is kept between boards, so bounds
+ * stored under one window are reused under others */
+static void
+verify_ab(const board_t *board, int player, bool *seen, int *num_boards,
+          int *num_mismatches)
+{
+    int i, num_empty, expected, actual, move;
+    int opponent = player == 1 ? 2 : 1;
+    int legal_moves[9];
+    board_t new_board;
+    move_order order;
+
+    if (seen[board_key(board)] || check_for_win(board) != -1) { return; }
+    seen[board_key(board)] = true;
+
+    expected = minimax_score(board, player, player, 0);
+    order_init(&order, (const int[9]){ 0 }, 9);
+    actual = minimax_ab_score(board, player, -SCORE_INF, SCORE_INF, &order);
+
+    /* The bot's move must keep the score the board is worth */
+    move = get_ab_pruning_bot_move(board, player);
+    new_board = *board;
+    board_place(&new_board, move, player);
+
+    (*num_boards)++;
+    if (actual != expected
+     || minimax_score(&new_board, opponent, player, 0) != expected) {
+        (*num_mismatches)++;
+        fprintf(stderr, "Mismatch on board %u: minimax %d, alpha-beta %d, "
+                "move %d\n", board_key(board), expected, actual, move);
+    } /* if */
+
+    num_empty = get_legal_moves(board, legal_moves);
+    for (i = 0; i < num_empty; i++) {
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], player);
+        verify_ab(&new_board, opponent, seen, num_boards, num_mismatches);
+    } /* for */
+}
+
+/* Benches every bot headlessly and prints the results as JSON */
+int
+main(int argc, char **argv)
+{
+    int i, num_positions;
+    int reps = 3;
+    bool warm = false, save = false, verify = false;
+    bool seen[PRECACHE_ENTRIES] = { false };
+    int num_boards = 0, num_mismatches = 0;
+    int num_batch_boards = 0, num_batch_mismatches = 0;
+    position positions[MAX_POSITIONS];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } /* if */
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            search_threads = atoi(argv[++i]);
+            if (search_threads < 1) { search_threads = 1; }
+        } /* else if */
+        else if (strcmp(argv[i], "--max-load") == 0 && i + 1 < argc) {
+            cache_max_load = atof(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc
+              && ht_find_hash(argv[i + 1]) != -1) {
+            cache_hash = ht_find_hash(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--warm") == 0) { warm = true; }
+        else if (strcmp(argv[i], "--save-caches") == 0) { save = true; }
+        else if (strcmp(argv[i], "--verify") == 0) { verify = true; }
+        else if (strcmp(argv[i], "--ordering") == 0 && i + 1 < argc
+              && order_parse(argv[i + 1], &move_ordering) == 0) {
+            i++;
+        } /* else if */
+        else {
+            fprintf(stderr, "Usage: %s [--reps N] [--threads N] [--warm] "
+                    "[--max-load F] [--hash NAME] [--save-caches] "
+                    "[--ordering none|all|LIST] [--verify]\n",
+                    argv[0]);
+            fprintf(stderr, "  LIST is a comma separated list of static, tt, "
+                    "killers and history\n");
+            fprintf(stderr, "  NAME is multiply-shift, fnv1a, x37 or "
+                    "zobrist\n");
+            return 1;
+        } /* else */
+    } /* for */
+
+    if (reps < 1) { reps = 1; }
+
+    num_positions = make_positions(positions);
+    precache_load(PRECACHE_PATH);
+    if (warm) { load_caches(); }
+    init_caches();
+
+    /* Checks the alpha-beta bot and the batch calls instead of benching */
+    if (verify) {
+        board_clear(&positions[0].board);
+        verify_ab(&positions[0].board, 1, seen, &num_boards, &num_mismatches);
+        num_batch_mismatches = verify_batch(&num_batch_boards);
+        printf("{\n");
+        printf("  \"boards\": %d,\n", num_boards);
+        printf("  \"mismatches\": %d,\n", num_mismatches);
+        printf("  \"batch_boards\": %d,\n", num_batch_boards);
+        printf("  \"batch_mismatches\": %d\n", num_batch_mismatches);
+        printf("}\n");
+        free_caches();
+        precache_unload();
+        return num_mismatches == 0 && num_batch_mismatches == 0 ? 0 : 1;
+    } /* if */
+
+    printf("{\n");
+    printf("  \"positions\": %d,\n", num_positions);
+    printf("  \"reps\": %d,\n", reps);
+    printf("  \"threads\": %d,\n", search_threads);
+    printf("  \"warm\": %s,\n", warm ? "true" : "false");
+    printf("  \"bots\": [\n");
+
+    for (i = 0; i < NUM_BOTS; i++) {
+        srand(BENCH_SEED);
+        bench_bot(i, positions, num_positions, reps);
+    } /* for */
+
+    printf("  ],\n");
+    printf("  \"max_load\": %.2f,\n", cache_max_load);
+    printf("  \"hash\": \"%s\",\n", ht_hash_names[cache->hash_id]);
+    printf("  \"caches\": {\n");
+    print_cache("cache", cache, false);
+    print_cache("fastcache", fast_cache, false);
+    print_cache("ab", ab_cache, true);
+    printf("  },\n");
+
+    bench_batch(reps);
+
+    printf("  \"mnk\": [\n");
+
+    for (i = 0; i < NUM_MNK_CONFIGS; i++) { bench_mnk(i); }
+
+    printf("  ]\n");
+    printf("}\n");
+
+    if (save && save_caches() != 0) {
+        fprintf(stderr, "Could not write the cache snapshots\n");
+    } /* if */
+
+    free_caches();
+    mnk_free_cache();
+    precache_unload();
+
+    return 0;
+}
+/* EOF */
@@ -0,0 +1,20 @@
+#include <stdio.h>
+
+#include "precache.h"
+
+/* Writes the precache file used by the precache bot */
+int
+main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : PRECACHE_PATH;
+
+    if (precache_generate(path) != 0) {
+        fprintf(stderr, "Could not write %s\n", path);
+        return 1;
+    } /* if */
+
+    printf("Wrote %s\n", path);
+
+    return 0;
+}
+/* EOF */
@@ -1,119 +1,722 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #include "hashtable.h"
 
+static const char snapshot_magic[4] = { 'T', 'T', 'T', 'H' };
+
+/* Random words XORed together by the Zobrist hash, one per value of each
+ * byte of the key */
+static uint64_t zobrist_keys[8][256];
+static pthread_once_t zobrist_once = PTHREAD_ONCE_INIT;
+
+const char *ht_hash_names[HT_NUM_HASHES] = {
+    "multiply-shift",
+    "fnv1a",
+    "x37",
+    "zobrist"
+};
+
+/* Multiply-shift hashing: the top bits of the product are well mixed */
+static unsigned int
+hash_multiply_shift(uint64_t key, unsigned int bits)
+{
+    return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+}
+
+/* FNV-1a over the bytes of the key, XOR-folded down to the bits wanted */
+static unsigned int
+hash_fnv1a(uint64_t key, unsigned int bits)
+{
+    int i;
+    uint64_t value = 0xCBF29CE484222325ULL;
+
+    for (i = 0; i < 8; i++) {
+        value = (value ^ (key >> (i * 8) & 0xFF)) * 0x100000001B3ULL;
+    } /* for */
+
+    return (value ^ value >> bits) & ((1U << bits) - 1);
+}
+
+/* The hash of the old string keyed table: each character of the board
+ * string times 37, modulo the size. The characters are the squares the key
+ * encodes in base 3, square 0 first, and there are at least 9 of them */
+static unsigned int
+hash_x37(uint64_t key, unsigned int bits)
+{
+    static const char marks[3] = { ' ', 'X', 'O' };
+    int i;
+    uint64_t value = 0;
+
+    for (i = 0; i < 9 || key != 0; i++) {
+        value = value * 37 + marks[key % 3];
+        key /= 3;
+    } /* for */
+
+    return value & ((1U << bits) - 1);
+}
+
+/* Fills in the Zobrist words from a fixed seed with splitmix64 */
+static void
+init_zobrist_keys(void)
+{
+    int i, j;
+    uint64_t state = 0, z;
+
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 256; j++) {
+            z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            zobrist_keys[i][j] = z ^ (z >> 31);
+        } /* for */
+    } /* for */
+}
+
+/* Zobrist (tabulation) hashing: XORs the random word of each byte of the
+ * key, like a board's Zobrist key XORs the word of each mark on it */
+static unsigned int
+hash_zobrist(uint64_t key, unsigned int bits)
+{
+    int i;
+    uint64_t value = 0;
+
+    for (i = 0; i < 8; i++) {
+        value ^= zobrist_keys[i][key >> (i * 8) & 0xFF];
+    } /* for */
+
+    return value >> (64 - bits);
+}
+
+static const ht_hash_func hash_funcs[HT_NUM_HASHES] = {
+    hash_multiply_shift,
+    hash_fnv1a,
+    hash_x37,
+    hash_zobrist
+};
+
+/* Hashes a key into a slot of an array */
+static unsigned int
+array_hash(const ht_t *hash_table, const ht_array *array, uint64_t key)
+{
+    return hash_table->hash_func(key, 64 - array->shift);
+}
+
 unsigned int
-hash(const char *key)
+hash(const ht_t *hash_table, uint64_t key)
+{
+    return array_hash(hash_table,
+                      __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE),
+                      key);
+}
+
+int
+ht_set_hash(ht_t *hash_table, int hash_id)
 {
-    unsigned long int value = 0;
-    unsigned int i = 0;
-    unsigned int key_len = strlen(key);
+    if (hash_id < 0 || hash_id >= HT_NUM_HASHES) { return -1; }
+
+    if (hash_id == HT_HASH_ZOBRIST) {
+        pthread_once(&zobrist_once, init_zobrist_keys);
+    } /* if */
+
+    hash_table->hash_id = hash_id;
+    hash_table->hash_func = hash_funcs[hash_id];
 
-    for (i = 0; i < key_len; i++) {
-        value = value * 37 + key[i];
+    return 0;
+}
+
+int
+ht_find_hash(const char *name)
+{
+    int i;
+
+    for (i = 0; i < HT_NUM_HASHES; i++) {
+        if (strcmp(name, ht_hash_names[i]) == 0) { return i; }
     } /* for */
 
-    value = value % TABLE_SIZE;
+    return -1;
+}
+
+/* Allocates an array of empty slots, or returns NULL if there is no memory
+ * for it. Where it can, the slots are mapped rather than cleared, so that
+ * the pages are zeroed as they are first touched instead of all at once */
+static ht_array *
+array_create(unsigned int size)
+{
+    unsigned int bits = 0;
+    ht_array *array = malloc(sizeof(ht_array));
+
+    if (array == NULL) { return NULL; }
 
-    return value;
+    /* Keeps at least one full probe group so that probes never wrap */
+    while ((1U << bits) < size || (1U << bits) < HT_MAX_PROBES) { bits++; }
+
+    array->size = 1U << bits;
+    array->shift = 64 - bits;
+    array->migrated = 0;
+    array->moved = 0;
+    array->mapped = false;
+    array->next_retired = NULL;
+#ifdef _WIN32
+    array->slots = _aligned_malloc(sizeof(ht_slot) * array->size, 64);
+    if (array->slots != NULL) {
+        memset(array->slots, 0, sizeof(ht_slot) * array->size);
+    } /* if */
+#else
+    array->slots = mmap(NULL, sizeof(ht_slot) * array->size,
+                        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1, 0);
+    if (array->slots == MAP_FAILED) { array->slots = NULL; }
+#endif
+
+    if (array->slots == NULL) {
+        free(array);
+        return NULL;
+    } /* if */
+
+    return array;
+}
+
+/* Frees an array. The slots of a mapped array go with the snapshot file */
+static void
+array_destroy(ht_array *array)
+{
+    if (!array->mapped) {
+#ifdef _WIN32
+        _aligned_free(array->slots);
+#else
+        munmap(array->slots, sizeof(ht_slot) * array->size);
+#endif
+    } /* if */
+
+    free(array);
 }
 
 ht_t *
-ht_create(void)
+ht_create(unsigned int size, double max_load)
 {
-    int i = 0;
-    ht_t *hash_table = malloc(sizeof(ht_t));
+    ht_t *hash_table = calloc(1, sizeof(ht_t));
 
-    hash_table->entries = malloc(sizeof(entry_t*) * TABLE_SIZE);
-    
-    for (i = 0; i < TABLE_SIZE; i++) {
-        hash_table->entries[i] = NULL;
-    } /* for */
+    if (hash_table == NULL) { return NULL; }
+
+    hash_table->cur = array_create(size);
+    if (hash_table->cur == NULL) {
+        free(hash_table);
+        return NULL;
+    } /* if */
+
+    hash_table->generation = 1;
+    ht_set_hash(hash_table, HT_HASH_MULTIPLY_SHIFT);
+    hash_table->max_load = max_load;
 
     return hash_table;
 }
 
-entry_t *
-ht_pair(const char *key, const char *value)
+/* Gets the first slot of the probe group a key lives in. A key is only ever
+ * stored in the HT_MAX_PROBES slots of its group */
+static unsigned int
+probe_group(const ht_t *hash_table, const ht_array *array, uint64_t key,
+            unsigned int *home)
 {
-    entry_t *entry = malloc(sizeof(entry_t));
-    entry->key = malloc(strlen(key) + 1);
-    entry->value = malloc(strlen(key) + 1);
+    *home = array_hash(hash_table, array, key);
 
-    strcpy(entry->key, key);
-    strcpy(entry->value, value);
+    return *home & ~(HT_MAX_PROBES - 1U);
+}
 
-    entry->next = NULL;
+/* Packs the fields of an entry and the table's generation into one word */
+static uint64_t
+pack_data(const ht_t *hash_table, int score, int flag, int move, int depth)
+{
+    return (uint64_t)(uint16_t)score | (uint64_t)(uint8_t)flag << 16
+         | (uint64_t)(uint8_t)move << 24 | (uint64_t)(uint8_t)depth << 32
+         | (uint64_t)hash_table->generation << HT_GENERATION_SHIFT;
+}
 
-    return entry;
+/* Checks whether the data of a slot was stored in the current generation.
+ * Slots that were never written have generation 0, which is never current */
+static bool
+is_live(const ht_t *hash_table, uint64_t data)
+{
+    return data >> HT_GENERATION_SHIFT == hash_table->generation;
 }
 
-void
-ht_set(ht_t *hash_table, const char *key, const char *value)
+/* Reads both words of a slot. Each word is read whole, but another thread
+ * may write the slot between the two reads */
+static void
+load_slot(const ht_slot *slot, uint64_t *check, uint64_t *data)
 {
-    unsigned int slot = hash(key);
-    entry_t *entry = hash_table->entries[slot];
-    entry_t *prev = NULL;
+    *data = __atomic_load_n(&slot->data, __ATOMIC_RELAXED);
+    *check = __atomic_load_n(&slot->check, __ATOMIC_RELAXED);
+}
 
-    if (entry == NULL) {
-        hash_table->entries[slot] = ht_pair(key, value);
+/* Finds the slot a store of a key goes to: the key's own slot, else the
+ * first free slot of its group, else NULL. Claiming a free slot counts it */
+static ht_slot *
+find_slot(ht_t *hash_table, const ht_array *array, uint64_t key)
+{
+    unsigned int i, home;
+    unsigned int group = probe_group(hash_table, array, key, &home);
+    uint64_t check, data;
+    ht_slot *slot;
+
+    for (i = 0; i < HT_MAX_PROBES; i++) {
+        slot = &array->slots[group + ((home + i) & (HT_MAX_PROBES - 1))];
+        load_slot(slot, &check, &data);
+        if (!is_live(hash_table, data)) {
+            __atomic_add_fetch(&hash_table->count, 1, __ATOMIC_RELAXED);
+            return slot;
+        } /* if */
+        if ((check ^ data) == key) { return slot; }
+    } /* for */
+
+    return NULL;
+}
+
+/* Writes both words of a slot */
+static void
+store_slot(ht_slot *slot, uint64_t key, uint64_t data)
+{
+    __atomic_store_n(&slot->data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+/* Doubles the table once it passes its load factor. Only one thread starts
+ * growing, and only once the last growth has finished moving. The old array
+ * is published before the new one, so a thread that sees the new array also
+ * sees where the entries not moved yet are. If there is no memory for a
+ * bigger array, the table keeps its size and growing stays set, so that it
+ * replaces entries like a fixed size table until it is reset */
+static void
+maybe_grow(ht_t *hash_table)
+{
+    ht_array *cur = __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE);
+    ht_array *bigger;
+    bool expected = false;
+
+    if (hash_table->max_load <= 0
+     || __atomic_load_n(&hash_table->count, __ATOMIC_RELAXED)
+        <= hash_table->max_load * cur->size
+     || __atomic_load_n(&hash_table->old, __ATOMIC_ACQUIRE) != NULL) {
         return;
     } /* if */
 
-    while (entry != NULL) {
-        if (strcmp(entry->key, key) == 0) {
-            free(entry->value);
-            entry->value = malloc(strlen(value) + 1);
-            strcpy(entry->value, value);
-            return;
-        } /* if */
-        prev = entry;
-        entry = prev->next;
-    } /* while */
+    if (!__atomic_compare_exchange_n(&hash_table->growing, &expected, true,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_RELAXED)) {
+        return;
+    } /* if */
+
+    bigger = cur->size * 2 == 0 ? NULL : array_create(cur->size * 2);
+    if (bigger == NULL) { return; }
+
+    /* The moves count the entries into the new array again */
+    __atomic_store_n(&hash_table->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&hash_table->old, cur, __ATOMIC_RELEASE);
+    __atomic_store_n(&hash_table->cur, bigger, __ATOMIC_RELEASE);
+}
+
+/* Moves the next HT_MIGRATE_SLOTS slots of the old array into the new one,
+ * if the table is growing. An entry the new array already has a newer copy
+ * of, or has no room for, is dropped. Whoever moves the last slot retires
+ * the old array */
+static void
+migrate_step(ht_t *hash_table)
+{
+    unsigned int i, start, end;
+    uint64_t key, check, data, cur_check, cur_data;
+    ht_slot *slot;
+    ht_array *old = __atomic_load_n(&hash_table->old, __ATOMIC_ACQUIRE);
+    ht_array *cur = __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE);
+
+    if (old == NULL) { return; }
+
+    start = __atomic_fetch_add(&old->migrated, HT_MIGRATE_SLOTS,
+                               __ATOMIC_RELAXED);
+    if (start >= old->size) { return; }
+    end = start + HT_MIGRATE_SLOTS < old->size ? start + HT_MIGRATE_SLOTS
+                                               : old->size;
+
+    for (i = start; i < end; i++) {
+        load_slot(&old->slots[i], &check, &data);
+        if (!is_live(hash_table, data)) { continue; }
+
+        key = check ^ data;
+        slot = find_slot(hash_table, cur, key);
+        if (slot == NULL) { continue; }
+
+        /* A live slot here already holds the key, stored since the growth
+         * began, and is newer */
+        load_slot(slot, &cur_check, &cur_data);
+        if (is_live(hash_table, cur_data)) { continue; }
+        store_slot(slot, key, data);
+    } /* for */
+
+    if (__atomic_add_fetch(&old->moved, end - start, __ATOMIC_ACQ_REL)
+        == old->size) {
+        old->next_retired = hash_table->retired;
+        hash_table->retired = old;
+        __atomic_store_n(&hash_table->old, NULL, __ATOMIC_RELEASE);
+        __atomic_store_n(&hash_table->growing, false, __ATOMIC_RELEASE);
+    } /* if */
+}
 
-    prev->next = ht_pair(key, value);
+void
+ht_set(ht_t *hash_table, uint64_t key, int score, int flag, int move,
+       int depth)
+{
+    unsigned int home;
+    ht_array *cur = __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE);
+    ht_slot *slot = find_slot(hash_table, cur, key);
+
+    /* Every slot of the group belongs to another key, so evict the home
+     * entry */
+    if (slot == NULL) {
+        probe_group(hash_table, cur, key, &home);
+        slot = &cur->slots[home];
+    } /* if */
+
+    store_slot(slot, key, pack_data(hash_table, score, flag, move, depth));
+
+    if (hash_table->max_load > 0) {
+        migrate_step(hash_table);
+        maybe_grow(hash_table);
+    } /* if */
+}
+
+/* Probes one array of the table for a key, counting the slots read */
+static bool
+array_find(const ht_t *hash_table, const ht_array *array, uint64_t key,
+           uint64_t *data, unsigned int *probes)
+{
+    unsigned int i, home;
+    unsigned int group = probe_group(hash_table, array, key, &home);
+    uint64_t check;
+
+    for (i = 0; i < HT_MAX_PROBES; i++) {
+        load_slot(&array->slots[group + ((home + i) & (HT_MAX_PROBES - 1))],
+                  &check, data);
+        *probes = i + 1;
+        if (!is_live(hash_table, *data)) { return false; }
+        if ((check ^ *data) == key) { return true; }
+    } /* for */
+
+    return false;
+}
+
+/* Looks up a key in one array of the table */
+static bool
+array_get(const ht_t *hash_table, const ht_array *array, uint64_t key,
+          entry_t *entry)
+{
+    unsigned int probes;
+    uint64_t data;
+
+    if (!array_find(hash_table, array, key, &data, &probes)) { return false; }
+
+    entry->key = key;
+    entry->score = (int16_t)(data & 0xFFFF);
+    entry->flag = data >> 16 & 0xFF;
+    entry->move = data >> 24 & 0xFF;
+    entry->depth = data >> 32 & 0xFF;
+
+    return true;
+}
+
+bool
+ht_get(const ht_t *hash_table, uint64_t key, entry_t *entry)
+{
+    const ht_array *old;
+
+    if (array_get(hash_table,
+                  __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE), key,
+                  entry)) {
+        return true;
+    } /* if */
+
+    /* While the table grows, entries not moved yet are still in the old
+     * array */
+    old = __atomic_load_n(&hash_table->old, __ATOMIC_ACQUIRE);
+
+    return old != NULL && array_get(hash_table, old, key, entry);
 }
 
-char *
-ht_get(const ht_t *hash_table, const char *key)
+unsigned int
+ht_probes(const ht_t *hash_table, uint64_t key)
 {
-    unsigned int slot = hash(key);
-    entry_t *entry = hash_table->entries[slot];
+    unsigned int probes;
+    uint64_t data;
+
+    array_find(hash_table,
+               __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE), key,
+               &data, &probes);
+
+    return probes;
+}
 
-    if (entry == NULL) { return NULL; }
+/* Frees the arrays the table has grown out of, and the one it is growing
+ * out of */
+static void
+free_retired(ht_t *hash_table)
+{
+    ht_array *array;
+
+    if (hash_table->old != NULL) {
+        hash_table->old->next_retired = hash_table->retired;
+        hash_table->retired = hash_table->old;
+        hash_table->old = NULL;
+    } /* if */
 
-    while (entry != NULL) {
-        if (strcmp(entry->key, key) == 0) { return entry->value; }
-        entry = entry->next;
+    while (hash_table->retired != NULL) {
+        array = hash_table->retired;
+        hash_table->retired = array->next_retired;
+        array_destroy(array);
     } /* while */
 
-    return NULL;
+    hash_table->growing = false;
 }
 
 void
-ht_dump(const ht_t *hash_table)
+ht_reset(ht_t *hash_table)
 {
-    int i;
-    entry_t *entry = NULL;
+    free_retired(hash_table);
+    hash_table->count = 0;
+    hash_table->generation++;
+
+    if (hash_table->generation > HT_MAX_GENERATION) {
+        memset(hash_table->cur->slots, 0,
+               sizeof(ht_slot) * hash_table->cur->size);
+        hash_table->generation = 1;
+    } /* if */
+}
 
-    for (i = 0; i < TABLE_SIZE; i++) {
-        entry = hash_table->entries[i];
+void
+ht_destroy(ht_t *hash_table)
+{
+    if (hash_table == NULL) { return; }
 
-        if (entry == NULL) { continue; }
+    free_retired(hash_table);
+    array_destroy(hash_table->cur);
 
-        printf("slot[%06d]: ", i);
+    if (hash_table->map != NULL) {
+#ifdef _WIN32
+        _aligned_free(hash_table->map);
+#else
+        munmap(hash_table->map, hash_table->map_len);
+#endif
+    } /* if */
 
-        while (1) {
-            printf("%s = %s ", entry->key, entry->value);
+    free(hash_table);
+}
 
-            if (entry->next == NULL) { break; }
-            
-            entry = entry->next;
-        } /* while */
+size_t
+ht_memory(const ht_t *hash_table)
+{
+    size_t bytes = sizeof(ht_t) + sizeof(ht_array)
+                   + sizeof(ht_slot) * hash_table->cur->size;
+    const ht_array *array;
 
-        printf("\n");
+    if (hash_table->old != NULL) {
+        bytes += sizeof(ht_array) + sizeof(ht_slot) * hash_table->old->size;
+    } /* if */
+    for (array = hash_table->retired; array != NULL;
+         array = array->next_retired) {
+        bytes += sizeof(ht_array) + sizeof(ht_slot) * array->size;
     } /* for */
+
+    return bytes;
+}
+
+unsigned int
+ht_size(const ht_t *hash_table)
+{
+    return __atomic_load_n(&hash_table->cur, __ATOMIC_ACQUIRE)->size;
+}
+
+int
+ht_save(ht_t *hash_table, const char *path)
+{
+    int status = 0;
+    size_t path_len = strlen(path);
+    char *tmp_path = malloc(path_len + 5);
+    FILE *file = NULL;
+    ht_snapshot_header header;
+
+    while (hash_table->old != NULL) { migrate_step(hash_table); }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, snapshot_magic, 4);
+    header.version = HT_SNAPSHOT_VERSION;
+    header.size = hash_table->cur->size;
+    header.count = hash_table->count;
+    header.generation = hash_table->generation;
+    header.slot_bytes = sizeof(ht_slot);
+    header.hash_id = hash_table->hash_id;
+
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        free(tmp_path);
+        return -1;
+    } /* if */
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+     || fwrite(hash_table->cur->slots, sizeof(ht_slot),
+               hash_table->cur->size, file) != hash_table->cur->size) {
+        status = -1;
+    } /* if */
+
+    if (fclose(file) != 0) { status = -1; }
+    if (status == 0 && rename(tmp_path, path) != 0) { status = -1; }
+    if (status != 0) { remove(tmp_path); }
+
+    free(tmp_path);
+
+    return status;
+}
+
+/* Checks that a mapped file holds a table this build can read */
+static bool
+snapshot_valid(const void *data, size_t len)
+{
+    const ht_snapshot_header *header = data;
+
+    if (len < sizeof(ht_snapshot_header)) { return false; }
+
+    return memcmp(header->magic, snapshot_magic, 4) == 0
+        && header->version == HT_SNAPSHOT_VERSION
+        && header->slot_bytes == sizeof(ht_slot)
+        && header->hash_id < HT_NUM_HASHES
+        && header->size >= HT_MAX_PROBES
+        && (header->size & (header->size - 1)) == 0
+        && header->generation >= 1
+        && header->generation <= HT_MAX_GENERATION
+        && len == sizeof(ht_snapshot_header)
+                  + (size_t)header->size * sizeof(ht_slot);
+}
+
+ht_t *
+ht_load(const char *path, double max_load)
+{
+    unsigned int bits = 0;
+    const ht_snapshot_header *header = NULL;
+    ht_t *hash_table = NULL;
+#ifdef _WIN32
+    FILE *file = NULL;
+    size_t len;
+    void *data = NULL;
+
+    file = fopen(path, "rb");
+    if (file == NULL) { return NULL; }
+
+    fseek(file, 0, SEEK_END);
+    len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = _aligned_malloc(len, 64);
+    if (data == NULL) {
+        fclose(file);
+        return NULL;
+    } /* if */
+    len = fread(data, 1, len, file);
+    fclose(file);
+#else
+    int fd;
+    struct stat st;
+    size_t len;
+    void *data = NULL;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) { return NULL; }
+
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return NULL;
+    } /* if */
+
+    /* Private and writable: stores copy the pages they touch instead of
+     * writing to the file */
+    len = st.st_size;
+    data = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) { return NULL; }
+#endif
+
+    header = data;
+    if (snapshot_valid(data, len)) {
+        hash_table = calloc(1, sizeof(ht_t));
+    } /* if */
+    if (hash_table != NULL) {
+        hash_table->cur = calloc(1, sizeof(ht_array));
+    } /* if */
+
+    if (hash_table == NULL || hash_table->cur == NULL) {
+        free(hash_table);
+#ifdef _WIN32
+        _aligned_free(data);
+#else
+        munmap(data, len);
+#endif
+        return NULL;
+    } /* if */
+
+    while ((1U << bits) < header->size) { bits++; }
+
+    hash_table->cur->slots = (ht_slot *)((char *)data
+                                         + sizeof(ht_snapshot_header));
+    hash_table->cur->size = header->size;
+    hash_table->cur->shift = 64 - bits;
+    hash_table->cur->mapped = true;
+    hash_table->count = header->count;
+    hash_table->generation = header->generation;
+    hash_table->max_load = max_load;
+    hash_table->map = data;
+    ht_set_hash(hash_table, header->hash_id);
+    hash_table->map_len = len;
+
+    return hash_table;
+}
+
+/* Prints every occupied slot of one array of the table */
+static void
+array_dump(const ht_t *hash_table, const ht_array *array)
+{
+    unsigned int i;
+    uint64_t check, data;
+
+    for (i = 0; i < array->size; i++) {
+        load_slot(&array->slots[i], &check, &data);
+
+        if (!is_live(hash_table, data)) { continue; }
+
+        printf("slot[%06u]: %llu = %d (flag %u, move %u, depth %u)\n", i,
+               (unsigned long long)(check ^ data), (int16_t)(data & 0xFFFF),
+               (unsigned int)(data >> 16 & 0xFF),
+               (unsigned int)(data >> 24 & 0xFF),
+               (unsigned int)(data >> 32 & 0xFF));
+    } /* for */
+}
+
+void
+ht_dump(const ht_t *hash_table)
+{
+    array_dump(hash_table, hash_table->cur);
+
+    if (hash_table->old != NULL) {
+        printf("still moving out of the old array:\n");
+        array_dump(hash_table, hash_table->old);
+    } /* if */
 }
 /* EOF */
@@ -1,33 +1,265 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 
-#define TABLE_SIZE 500000
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Stored as the move of an entry that does not know its best move */
+#define HT_NO_MOVE 0xFF
+
+/* Stored as the depth of an entry searched to the end of the game */
+#define HT_SOLVED 0xFF
+
+/* Slots in a probe group. A key is only stored in the group its home slot is
+ * in, starting at the home slot and wrapping around within the group */
+#define HT_MAX_PROBES 16
+
+/* Slots of the old array each store moves into the new one while a table
+ * grows. Enough to finish the move before the new array fills up at any load
+ * factor above 1/HT_MIGRATE_SLOTS */
+#define HT_MIGRATE_SLOTS 64
+
+/* Load factor a growable table doubles at unless told otherwise */
+#define HT_DEFAULT_MAX_LOAD 0.5
+
+/* data keeps the generation of the table it was stored in above this bit */
+#define HT_GENERATION_SHIFT 40
+#define HT_MAX_GENERATION ((1U << (64 - HT_GENERATION_SHIFT)) - 1)
+
+/* Bumped whenever the layout of a snapshot file, the slots of a table or the
+ * meaning of the scores stored in them change */
+#define HT_SNAPSHOT_VERSION 2
+
+/* The functions a table can hash its keys with. Multiply-shift is the
+ * default; the others are kept to compare against (see ttt_htbench) */
+enum ht_hashes {
+    HT_HASH_MULTIPLY_SHIFT = 0,
+    HT_HASH_FNV1A = 1,
+    HT_HASH_X37 = 2,
+    HT_HASH_ZOBRIST = 3,
+    HT_NUM_HASHES = 4
+};
+
+/* Hashes a key into one of 2^bits slots */
+typedef unsigned int (*ht_hash_func)(uint64_t key, unsigned int bits);
 
 typedef struct entry_t entry_t;
+typedef struct ht_slot_t ht_slot;
+typedef struct ht_array_t ht_array;
 typedef struct ht_t ht_t;
+typedef struct ht_snapshot_header_t ht_snapshot_header;
+
+enum entry_flags {
+    HT_EMPTY = 0,
+    HT_EXACT = 1,
+    HT_LOWER = 2,
+    HT_UPPER = 3
+};
 
+/* An entry as it is read out of the table */
 struct entry_t
 {
-    char *key;
-    char *value;
-    struct entry_t *next;
+    uint64_t key;
+    int16_t score;
+    uint8_t flag;
+    uint8_t move;
+    uint8_t depth;
+};
+
+/* One 16 byte slot of the table. data packs the fields of the entry and
+ * check is its key XORed with data, so a slot torn by two threads writing at
+ * once fails the key check instead of being read as a mix of two entries.
+ * A slot is free unless data holds the current generation of the table */
+struct ht_slot_t
+{
+    uint64_t check;
+    uint64_t data;
 };
 
+/* The slots of a table at one size. An array a table has grown out of is
+ * kept on its retired list until the table is reset or destroyed, since a
+ * thread may still be reading it. While its entries move out, migrated
+ * counts the slots claimed for moving and moved those done. mapped is set if
+ * the slots live in a snapshot file rather than their own allocation */
+struct ht_array_t
+{
+    ht_slot *slots;
+    unsigned int size;
+    unsigned int shift;
+    unsigned int migrated;
+    unsigned int moved;
+    bool mapped;
+    ht_array *next_retired;
+};
+
+/* Any number of threads may read and write a table at once without locks.
+ * Entries are only ever lost to a race, never mixed up. All of the slots are
+ * one allocation, so emptying the table only takes a new generation.
+ *
+ * A table with a max_load grows by doubling once count passes max_load of its
+ * slots. Stores then go to the new array, lookups try the new array before
+ * the old one, and every store moves the next HT_MIGRATE_SLOTS slots of the
+ * old array over, so no store pays for more than that. map is the snapshot
+ * file the first array lives in, or NULL if it was allocated. hash_id is
+ * the ht_hashes value of hash_func */
 struct ht_t
 {
-    entry_t **entries;
+    ht_hash_func hash_func;
+    int hash_id;
+    ht_array *cur;
+    ht_array *old;
+    ht_array *retired;
+    unsigned int count;
+    unsigned int generation;
+    double max_load;
+    bool growing;
+    void *map;
+    size_t map_len;
+};
+
+/* A snapshot file is this header followed by the slots of the table exactly
+ * as they are in memory, in host byte order. The header fills a cache line so
+ * that the mapped slots stay aligned. hash_id is the function the slots were
+ * placed with, which the loaded table keeps using */
+struct ht_snapshot_header_t
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t size;
+    uint32_t count;
+    uint32_t generation;
+    uint32_t slot_bytes;
+    uint32_t hash_id;
+    uint8_t reserved[36];
 };
 
-unsigned int hash(const char *key);
+/* The name of each hash function, indexed by ht_hashes */
+extern const char *ht_hash_names[HT_NUM_HASHES];
+
+/**
+ * Hashes a key into a slot of the table
+ * @param hash_table The hashtable
+ * @param key The key to hash
+ * @return The home slot of the key
+ */
+unsigned int hash(const ht_t *hash_table, uint64_t key);
+
+/**
+ * Creates a hashtable
+ * @param size The number of slots in the table. Rounded up to a power of two
+ * @param max_load The share of the slots in use (0 to 1) at which the table
+ * doubles, or 0 to keep the size fixed and replace entries instead. A
+ * table that has no memory to double into keeps its size
+ * @return The hashtable, with every slot empty, or NULL if there is no
+ * memory for it
+ */
+ht_t *ht_create(unsigned int size, double max_load);
+
+/**
+ * Picks the function a table hashes its keys with. Only call it on an empty
+ * table that no other thread uses yet
+ * @param hash_table The hashtable
+ * @param hash_id The function to use (one of ht_hashes)
+ * @return 0 on success, -1 if hash_id is not a known function
+ */
+int ht_set_hash(ht_t *hash_table, int hash_id);
+
+/**
+ * Looks up a hash function by name
+ * @param name The name, as in ht_hash_names
+ * @return The ht_hashes value of the function, or -1 if there is none
+ */
+int ht_find_hash(const char *name);
+
+/**
+ * Stores an entry, replacing the entry for the same key if there is one. If
+ * every slot of the key's probe group is taken, the entry in its home slot is
+ * replaced
+ * @param hash_table The hashtable
+ * @param key The key of the entry
+ * @param score The score to store
+ * @param flag The kind of score stored (one of entry_flags, not HT_EMPTY)
+ * @param move The best move found for the position
+ * @param depth The number of plies searched below the position
+ */
+void ht_set(ht_t *hash_table, uint64_t key, int score, int flag, int move,
+            int depth);
+
+/**
+ * Looks up the entry for a key
+ * @param hash_table The hashtable
+ * @param key The key to look up
+ * @param entry A copy of the entry for the key. Passed in as an out value and
+ * only written if the key is found
+ * @return Whether the key is in the table
+ */
+bool ht_get(const ht_t *hash_table, uint64_t key, entry_t *entry);
+
+/**
+ * Counts the slots a lookup of a key reads in the array stores go to
+ * @param hash_table The hashtable
+ * @param key The key to look up
+ * @return The number of slots read, from 1 to HT_MAX_PROBES
+ */
+unsigned int ht_probes(const ht_t *hash_table, uint64_t key);
+
+/**
+ * Empties the table in O(1) by moving it to a new generation, which frees
+ * every slot of the old one. Only clears the slots when the generations run
+ * out. The table keeps the size it has grown to, but frees the arrays it grew
+ * out of. No other thread may use the table meanwhile
+ * @param hash_table The hashtable
+ */
+void ht_reset(ht_t *hash_table);
+
+/**
+ * Frees the table and its slots
+ * @param hash_table The hashtable. May be NULL
+ */
+void ht_destroy(ht_t *hash_table);
 
-ht_t *ht_create(void);
+/**
+ * Gets the number of bytes a table holds, counting every array it has grown
+ * out of that is not freed yet
+ * @param hash_table The hashtable
+ * @return The bytes of the table and its slots
+ */
+size_t ht_memory(const ht_t *hash_table);
 
-entry_t *ht_pair(const char *key, const char *value);
+/**
+ * Gets the number of slots stores go to
+ * @param hash_table The hashtable
+ * @return The slots of the current array
+ */
+unsigned int ht_size(const ht_t *hash_table);
 
-void ht_set(ht_t *hash_table, const char *key, const char *value);
+/**
+ * Writes the table to a snapshot file. A table in the middle of growing
+ * finishes first. The file is written beside the path and renamed over it,
+ * so a process that has the old file mapped keeps reading the old file. No
+ * other thread may use the table meanwhile
+ * @param hash_table The hashtable
+ * @param path The path of the file to write
+ * @return 0 on success, -1 if the file could not be written
+ */
+int ht_save(ht_t *hash_table, const char *path);
 
-char *ht_get(const ht_t *hash_table, const char *key);
+/**
+ * Loads a table from a snapshot file by mapping it copy-on-write, so that
+ * nothing is read until it is probed and the file never changes. The table
+ * hashes with the function it was saved with
+ * @param path The path of the file to map
+ * @param max_load The load factor the table grows at, as in ht_create
+ * @return The hashtable, or NULL if the file is missing or invalid or there
+ * is no memory for it
+ */
+ht_t *ht_load(const char *path, double max_load);
 
+/**
+ * Prints every occupied slot of the table
+ * @param hash_table The hashtable
+ */
 void ht_dump(const ht_t *hash_table);
 
 #endif
@@ -0,0 +1,94 @@
+#include <string.h>
+
+#include "histogram.h"
+
+/* Gets the bucket of a value. A value with its top bit at position b >=
+ * HIST_SUB_BITS is shifted right until it fits in HIST_SUB_BITS bits, which
+ * leaves it in the upper half of the sub-buckets */
+static int
+bucket_of(uint64_t value)
+{
+    int shift;
+
+    if (value < HIST_SUB_COUNT) { return (int)value; }
+
+    shift = 63 - __builtin_clzll(value) - (HIST_SUB_BITS - 1);
+
+    return shift * HIST_HALF_COUNT + (int)(value >> shift);
+}
+
+/* Gets the highest value that falls in a bucket */
+static uint64_t
+bucket_max(int bucket)
+{
+    int shift;
+
+    if (bucket < HIST_SUB_COUNT) { return bucket; }
+
+    shift = bucket / HIST_HALF_COUNT - 1;
+
+    return ((uint64_t)(bucket - shift * HIST_HALF_COUNT + 1) << shift) - 1;
+}
+
+/* Empties a histogram */
+void
+hist_init(histogram *hist)
+{
+    memset(hist, 0, sizeof(histogram));
+    hist->min = UINT64_MAX;
+}
+
+/* Records a value */
+void
+hist_record(histogram *hist, uint64_t value)
+{
+    hist->counts[bucket_of(value)]++;
+    hist->total++;
+    hist->sum += value;
+    if (value < hist->min) { hist->min = value; }
+    if (value > hist->max) { hist->max = value; }
+}
+
+/* Adds every value recorded in one histogram to another */
+void
+hist_merge(histogram *dst, const histogram *src)
+{
+    int i;
+
+    for (i = 0; i < HIST_BUCKETS; i++) { dst->counts[i] += src->counts[i]; }
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min) { dst->min = src->min; }
+    if (src->max > dst->max) { dst->max = src->max; }
+}
+
+/* Gets a percentile of the recorded values by the nearest rank */
+uint64_t
+hist_percentile(const histogram *hist, double p)
+{
+    int i;
+    uint64_t seen = 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * hist->total + 0.999999);
+
+    if (hist->total == 0) { return 0; }
+    if (rank < 1) { rank = 1; }
+    if (rank > hist->total) { rank = hist->total; }
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            /* The bucket may reach past the largest value recorded */
+            return bucket_max(i) < hist->max ? bucket_max(i) : hist->max;
+        } /* if */
+    } /* for */
+
+    return hist->max;
+}
+
+/* Gets the mean of the recorded values */
+double
+hist_mean(const histogram *hist)
+{
+    return hist->total == 0 ? 0.0 : hist->sum / hist->total;
+}
+/* EOF */
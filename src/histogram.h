@@ -0,0 +1,67 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/* Each power of two is split into 2^(HIST_SUB_BITS - 1) buckets, so a
+ * recorded value is off by less than 1 part in 64 (about 1.6%) */
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_HALF_COUNT (HIST_SUB_COUNT / 2)
+
+/* Buckets needed to cover every 64-bit value */
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 2) * HIST_HALF_COUNT)
+
+typedef struct histogram_t histogram;
+
+/* A log-linear histogram in the style of HdrHistogram. Values below
+ * HIST_SUB_COUNT get a bucket each, and every power of two above that gets
+ * HIST_HALF_COUNT buckets, so the error stays relative to the value and
+ * recording is a few shifts with no allocation */
+struct histogram_t
+{
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+};
+
+/**
+ * Empties a histogram
+ * @param hist The histogram
+ */
+void hist_init(histogram *hist);
+
+/**
+ * Records a value
+ * @param hist The histogram
+ * @param value The value, such as a latency in nanoseconds
+ */
+void hist_record(histogram *hist, uint64_t value);
+
+/**
+ * Adds every value recorded in one histogram to another
+ * @param dst The histogram to add to
+ * @param src The histogram to add
+ */
+void hist_merge(histogram *dst, const histogram *src);
+
+/**
+ * Gets a percentile of the recorded values
+ * @param hist The histogram
+ * @param p The percentile, eg 99.9
+ * @return The highest value of the bucket the percentile falls in (the
+ * largest value it could have been), or 0 if nothing was recorded
+ */
+uint64_t hist_percentile(const histogram *hist, double p);
+
+/**
+ * Gets the mean of the recorded values
+ * @param hist The histogram
+ * @return The mean, or 0 if nothing was recorded
+ */
+double hist_mean(const histogram *hist);
+
+#endif
+/* EOF */
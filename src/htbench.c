@@ -0,0 +1,394 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashtable.h"
+#include "precache.h"
+#include "util.h"
+
+#define DEFAULT_KEYS (1 << 20)
+
+/* Seed of the random keys, so that every build benches the same keys */
+#define HTBENCH_SEED 12345
+
+/* Home slots holding this many keys or more share the last bucket */
+#define HOME_BUCKETS 8
+
+typedef struct run_result_t run_result;
+
+/* The kinds of keys benched. Each set has a second half of keys that are
+ * never stored, which the missed lookups use:
+ * - boards: every reachable 3x3 board key, as the search caches store them.
+ *   Misses are the keys of unreachable boards
+ * - sequential: 0, 1, 2 and so on
+ * - strided: multiples of 65536, which only differ in their high bits
+ * - random: random 64-bit words, like the Zobrist keys of m,n,k boards */
+enum key_sets {
+    KEYS_BOARDS,
+    KEYS_SEQUENTIAL,
+    KEYS_STRIDED,
+    KEYS_RANDOM,
+    NUM_KEY_SETS
+};
+
+static const char *key_set_names[NUM_KEY_SETS] = {
+    "boards",
+    "sequential",
+    "strided",
+    "random"
+};
+
+/* What one hash function did on one set of keys. The times are per key and
+ * the probe counts are of the fixed size table */
+struct run_result_t
+{
+    double hash_ns;
+    double insert_ns;
+    double hit_ns;
+    double miss_ns;
+    double grow_insert_ns;
+    unsigned int slots;
+    unsigned int grow_slots;
+    size_t lost;
+    size_t grow_lost;
+    size_t bytes;
+    size_t grow_bytes;
+    unsigned long long hit_probes[HT_MAX_PROBES + 1];
+    unsigned long long miss_probes[HT_MAX_PROBES + 1];
+    unsigned long long home_keys[HOME_BUCKETS];
+    unsigned int max_home_keys;
+};
+
+/* Advances a splitmix64 generator */
+static uint64_t
+splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/* Fills in the keys of a set: the stored keys, then as many that are never
+ * stored. keys must hold 2 * num_keys keys
+ * @return The number of keys to store, which is less than num_keys for the
+ * boards */
+static size_t
+make_keys(int set, uint64_t *keys, size_t num_keys)
+{
+    size_t i, num_stored = 0, num_missed = 0;
+    uint32_t key;
+    uint64_t state = HTBENCH_SEED;
+    const uint16_t *table;
+
+    switch (set) {
+        case KEYS_BOARDS:
+            table = precache_get_table();
+            for (key = 0; key < PRECACHE_ENTRIES; key++) {
+                if (precache_result(table[key]) != -1
+                 && num_stored < num_keys) {
+                    keys[num_stored++] = key;
+                } /* if */
+            } /* for */
+            for (key = 0; key < PRECACHE_ENTRIES; key++) {
+                if (precache_result(table[key]) == -1
+                 && num_missed < num_stored) {
+                    keys[num_stored + num_missed++] = key;
+                } /* if */
+            } /* for */
+            return num_stored;
+        case KEYS_SEQUENTIAL:
+            for (i = 0; i < 2 * num_keys; i++) { keys[i] = i; }
+            break;
+        case KEYS_STRIDED:
+            for (i = 0; i < 2 * num_keys; i++) {
+                keys[i] = (uint64_t)i << 16;
+            } /* for */
+            break;
+        default:
+            for (i = 0; i < 2 * num_keys; i++) {
+                keys[i] = splitmix64(&state);
+            } /* for */
+            break;
+    } /* switch */
+
+    return num_keys;
+}
+
+/* Stores every key, timing the stores
+ * @return The nanoseconds taken */
+static long long
+insert_keys(ht_t *table, const uint64_t *keys, size_t num_keys)
+{
+    size_t i;
+    long long start = now_ns();
+
+    for (i = 0; i < num_keys; i++) {
+        ht_set(table, keys[i], (int)(i & 0x3FFF), HT_EXACT, HT_NO_MOVE,
+               HT_SOLVED);
+    } /* for */
+
+    return now_ns() - start;
+}
+
+/* Looks up every key, timing the lookups
+ * @return The nanoseconds taken */
+static long long
+find_keys(const ht_t *table, const uint64_t *keys, size_t num_keys,
+          size_t *num_found)
+{
+    size_t i, found = 0;
+    long long start = now_ns();
+    entry_t entry;
+
+    for (i = 0; i < num_keys; i++) {
+        found += ht_get(table, keys[i], &entry);
+    } /* for */
+
+    *num_found = found;
+
+    return now_ns() - start;
+}
+
+/* Benches one hash function on one set of keys */
+static void
+bench_hash(int hash_id, const uint64_t *keys, size_t num_keys, double load,
+           double max_load, int reps, run_result *result)
+{
+    int rep;
+    size_t i, found;
+    unsigned int *home_counts;
+    unsigned int sink = 0;
+    long long start, hash_ns = 0, insert_ns = 0, hit_ns = 0, miss_ns = 0;
+    long long grow_ns = 0;
+    ht_t *table = ht_create((unsigned int)(num_keys / load), 0);
+    ht_t *grown = NULL;
+
+    if (table == NULL) {
+        fprintf(stderr, "No memory for a table of %zu keys\n", num_keys);
+        exit(1);
+    } /* if */
+
+    memset(result, 0, sizeof(run_result));
+    ht_set_hash(table, hash_id);
+
+    for (rep = 0; rep < reps; rep++) {
+        start = now_ns();
+        for (i = 0; i < num_keys; i++) { sink += hash(table, keys[i]); }
+        hash_ns += now_ns() - start;
+
+        ht_reset(table);
+        insert_ns += insert_keys(table, keys, num_keys);
+        hit_ns += find_keys(table, keys, num_keys, &found);
+        miss_ns += find_keys(table, keys + num_keys, num_keys, &found);
+
+        /* Each growing run starts from the smallest table again */
+        ht_destroy(grown);
+        grown = ht_create(CACHE_SIZE, max_load);
+        if (grown == NULL) {
+            fprintf(stderr, "No memory for a growing table\n");
+            exit(1);
+        } /* if */
+        ht_set_hash(grown, hash_id);
+        grow_ns += insert_keys(grown, keys, num_keys);
+    } /* for */
+
+    /* Keeps the hashing loop from being optimized away */
+    if (sink == 1) { fprintf(stderr, " "); }
+
+    result->hash_ns = (double)hash_ns / reps / num_keys;
+    result->insert_ns = (double)insert_ns / reps / num_keys;
+    result->hit_ns = (double)hit_ns / reps / num_keys;
+    result->miss_ns = (double)miss_ns / reps / num_keys;
+    result->grow_insert_ns = (double)grow_ns / reps / num_keys;
+    result->slots = ht_size(table);
+    result->grow_slots = ht_size(grown);
+    result->bytes = ht_memory(table);
+    result->grow_bytes = ht_memory(grown);
+
+    find_keys(table, keys, num_keys, &found);
+    result->lost = num_keys - found;
+    find_keys(grown, keys, num_keys, &found);
+    result->grow_lost = num_keys - found;
+
+    for (i = 0; i < num_keys; i++) {
+        result->hit_probes[ht_probes(table, keys[i])]++;
+        result->miss_probes[ht_probes(table, keys[num_keys + i])]++;
+    } /* for */
+
+    /* The keys that hash to each home slot, stored or not */
+    home_counts = calloc(result->slots, sizeof(unsigned int));
+    for (i = 0; i < num_keys; i++) { home_counts[hash(table, keys[i])]++; }
+    for (i = 0; i < result->slots; i++) {
+        if (home_counts[i] > result->max_home_keys) {
+            result->max_home_keys = home_counts[i];
+        } /* if */
+        result->home_keys[home_counts[i] < HOME_BUCKETS ? home_counts[i]
+                                                        : HOME_BUCKETS - 1]++;
+    } /* for */
+
+    free(home_counts);
+    ht_destroy(table);
+    ht_destroy(grown);
+}
+
+/* Prints a histogram as a JSON array, from its first bucket to its last */
+static void
+print_counts(const char *name, const unsigned long long *counts, int first,
+             int last)
+{
+    int i;
+
+    printf("      \"%s\": [", name);
+    for (i = first; i <= last; i++) {
+        printf("%llu%s", counts[i], i == last ? "" : ", ");
+    } /* for */
+    printf("],\n");
+}
+
+/* Gets the mean number of slots a lookup read */
+static double
+mean_probes(const unsigned long long *counts, size_t num_keys)
+{
+    int i;
+    unsigned long long total = 0;
+
+    for (i = 1; i <= HT_MAX_PROBES; i++) { total += counts[i] * i; }
+
+    return (double)total / num_keys;
+}
+
+/* Prints the JSON object of one run */
+static void
+print_run(int set, int hash_id, size_t num_keys, const run_result *result,
+          bool last)
+{
+    printf("    {\n");
+    printf("      \"keys\": \"%s\",\n", key_set_names[set]);
+    printf("      \"hash\": \"%s\",\n", ht_hash_names[hash_id]);
+    printf("      \"count\": %zu,\n", num_keys);
+    printf("      \"slots\": %u,\n", result->slots);
+    printf("      \"hash_ns\": %.2f,\n", result->hash_ns);
+    printf("      \"insert_ns\": %.2f,\n", result->insert_ns);
+    printf("      \"hit_ns\": %.2f,\n", result->hit_ns);
+    printf("      \"miss_ns\": %.2f,\n", result->miss_ns);
+    printf("      \"inserts_per_sec\": %.0f,\n",
+           result->insert_ns > 0 ? 1e9 / result->insert_ns : 0.0);
+    printf("      \"lookups_per_sec\": %.0f,\n",
+           result->hit_ns > 0 ? 1e9 / result->hit_ns : 0.0);
+    printf("      \"lost\": %zu,\n", result->lost);
+    printf("      \"mean_hit_probes\": %.3f,\n",
+           mean_probes(result->hit_probes, num_keys));
+    printf("      \"mean_miss_probes\": %.3f,\n",
+           mean_probes(result->miss_probes, num_keys));
+    print_counts("hit_probes", result->hit_probes, 1, HT_MAX_PROBES);
+    print_counts("miss_probes", result->miss_probes, 1, HT_MAX_PROBES);
+    print_counts("home_slot_keys", result->home_keys, 0, HOME_BUCKETS - 1);
+    printf("      \"max_home_slot_keys\": %u,\n", result->max_home_keys);
+    printf("      \"bytes_per_entry\": %.2f,\n",
+           (double)result->bytes / (num_keys - result->lost));
+    printf("      \"grow_insert_ns\": %.2f,\n", result->grow_insert_ns);
+    printf("      \"grow_slots\": %u,\n", result->grow_slots);
+    printf("      \"grow_lost\": %zu,\n", result->grow_lost);
+    printf("      \"grow_bytes_per_entry\": %.2f\n",
+           (double)result->grow_bytes / (num_keys - result->grow_lost));
+    printf("    }%s\n", last ? "" : ",");
+}
+
+/* Benches every hash function of the hashtable on several kinds of keys and
+ * prints the results as JSON */
+int
+main(int argc, char **argv)
+{
+    int i, set, hash_id, reps = 3;
+    int only_set = -1, only_hash = -1;
+    size_t num_keys = DEFAULT_KEYS, num_stored;
+    double load = 0.5, max_load = HT_DEFAULT_MAX_LOAD;
+    uint64_t *keys;
+    run_result result;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            num_keys = strtoul(argv[++i], NULL, 10);
+        } /* if */
+        else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            load = atof(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--max-load") == 0 && i + 1 < argc) {
+            max_load = atof(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc
+              && ht_find_hash(argv[i + 1]) != -1) {
+            only_hash = ht_find_hash(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) {
+            for (only_set = NUM_KEY_SETS - 1; only_set >= 0; only_set--) {
+                if (strcmp(argv[i + 1], key_set_names[only_set]) == 0) {
+                    break;
+                } /* if */
+            } /* for */
+            if (only_set == -1) { break; }
+            i++;
+        } /* else if */
+        else { break; }
+    } /* for */
+
+    if (i < argc || num_keys < 1 || load <= 0 || load > 1 || max_load <= 0
+     || max_load > 1) {
+        fprintf(stderr, "Usage: %s [--keys N] [--load F] [--max-load F] "
+                "[--reps N] [--hash NAME] [--set NAME]\n", argv[0]);
+        fprintf(stderr, "  --load is the share of slots the fixed size "
+                "tables fill and --max-load\n  the share the growing "
+                "tables double at, both above 0 and at most 1\n");
+        fprintf(stderr, "  hashes: multiply-shift, fnv1a, x37, zobrist\n");
+        fprintf(stderr, "  sets: boards, sequential, strided, random\n");
+        return 1;
+    } /* if */
+
+    if (reps < 1) { reps = 1; }
+
+    precache_load(PRECACHE_PATH);
+    if (precache_get_table() == NULL) {
+        fprintf(stderr, "No memory for the precache table\n");
+        return 1;
+    } /* if */
+    keys = malloc(sizeof(uint64_t) * 2 * num_keys);
+
+    printf("{\n");
+    printf("  \"keys\": %zu,\n", num_keys);
+    printf("  \"load\": %.2f,\n", load);
+    printf("  \"max_load\": %.2f,\n", max_load);
+    printf("  \"reps\": %d,\n", reps);
+    printf("  \"runs\": [\n");
+
+    for (set = 0; set < NUM_KEY_SETS; set++) {
+        if (only_set != -1 && set != only_set) { continue; }
+
+        num_stored = make_keys(set, keys, num_keys);
+
+        for (hash_id = 0; hash_id < HT_NUM_HASHES; hash_id++) {
+            if (only_hash != -1 && hash_id != only_hash) { continue; }
+
+            bench_hash(hash_id, keys, num_stored, load, max_load, reps,
+                       &result);
+            print_run(set, hash_id, num_stored, &result,
+                      (only_set != -1 || set == NUM_KEY_SETS - 1)
+                      && (only_hash != -1 || hash_id == HT_NUM_HASHES - 1));
+        } /* for */
+    } /* for */
+
+    printf("  ]\n");
+    printf("}\n");
+
+    free(keys);
+    precache_unload();
+
+    return 0;
+}
+/* EOF */
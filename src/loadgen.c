@@ -0,0 +1,508 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "histogram.h"
+#include "net.h"
+#include "util.h"
+
+/* Events handled per epoll_wait */
+#define MAX_EVENTS 256
+
+#define DEFAULT_CLIENTS 1000
+#define DEFAULT_GAMES 10
+
+typedef struct client_t client;
+
+enum client_states {
+    CLIENT_CONNECTING,
+    CLIENT_IDLE,
+    CLIENT_GREETING,
+    CLIENT_PLAYING,
+    CLIENT_DONE
+};
+
+/* The latencies measured, each from the message that asks for an answer to
+ * the answer arriving:
+ * - hello: our HELLO until the server's HELLO
+ * - sync: our MOVE until its SYNC
+ * - move: the start of the server's turn (its HELLO or the SYNC of our move)
+ *   until its MOVE. When watching, the server's previous MOVE
+ * - result: the move that ended the game until the RESULT */
+enum latency_types {
+    LAT_HELLO,
+    LAT_SYNC,
+    LAT_MOVE,
+    LAT_RESULT,
+    NUM_LAT_TYPES
+};
+
+static const char *latency_names[NUM_LAT_TYPES] = {
+    "hello",
+    "sync",
+    "move",
+    "result"
+};
+
+/* One simulated player, playing random moves on its own connection. waiting
+ * is the latency type of the answer it waits for, timed from wait_start_ns.
+ * hanging_up is set for a game the client walks away from */
+struct client_t
+{
+    net_conn *conn;
+    int id;
+    int state;
+    int seat;
+    int games_left;
+    board_t board;
+    int cur_player;
+    int turn;
+    int waiting;
+    long long wait_start_ns;
+    bool hanging_up;
+};
+
+/* Settings of the run */
+static int num_clients = DEFAULT_CLIENTS;
+static int games_per_client = DEFAULT_GAMES;
+static double games_per_sec = 0;
+static bool watch = false;
+static int bot = 0;
+static double hangup_share = 0;
+
+/* Totals of the run */
+static histogram latencies[NUM_LAT_TYPES];
+static long long games_played = 0;
+static long long messages = 0;
+static long long errors = 0;
+static long long connected = 0;
+static long long hangups = 0;
+static int clients_done = 0;
+static int epoll_fd = -1;
+
+/* Games started at a fixed rate wait here for their turn */
+static client **idle_clients = NULL;
+static int num_idle = 0;
+static long long next_start_ns = 0;
+
+/* Raises the limit on open files as far as it goes, so that thousands of
+ * clients can connect */
+static void
+raise_file_limit(void)
+{
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    } /* if */
+}
+
+/* Records the answer a client was waiting for */
+static void
+answered(client *c)
+{
+    hist_record(&latencies[c->waiting], now_ns() - c->wait_start_ns);
+    messages++;
+}
+
+/* Starts timing the next answer a client waits for */
+static void
+wait_for(client *c, int type)
+{
+    c->waiting = type;
+    c->wait_start_ns = now_ns();
+}
+
+/* Stops watching a client that has played all of its games */
+static void
+retire_client(client *c)
+{
+    c->state = CLIENT_DONE;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->conn->fd, NULL);
+    clients_done++;
+}
+
+/* Gives up on a client that lost its connection or got a bad answer */
+static void
+fail_client(client *c)
+{
+    errors++;
+    retire_client(c);
+}
+
+/* Closes a client's connection in the middle of its game, just after its
+ * move reached the server and the server's bot started thinking. The client
+ * plays no more games */
+static void
+hang_up(client *c)
+{
+    hangups++;
+    retire_client(c);
+    net_conn_destroy(c->conn);
+    c->conn = NULL;
+}
+
+/* Opens the next game of a client */
+static void
+start_game(client *c)
+{
+    net_msg msg = { 0 };
+
+    c->seat = watch ? 0 : (c->id + c->games_left) % 2 + 1;
+    c->cur_player = 1;
+    c->turn = 1;
+    c->hanging_up = hangup_share > 0 && rand() < hangup_share * RAND_MAX;
+    board_clear(&c->board);
+
+    msg.type = MSG_HELLO;
+    msg.version = NET_PROTOCOL_VERSION;
+    msg.seat = c->seat;
+    msg.bot = bot;
+    c->state = CLIENT_GREETING;
+    wait_for(c, LAT_HELLO);
+    if (net_send(c->conn, &msg) == -1) { fail_client(c); }
+}
+
+/* Queues a client for its next game, or starts it right away if games are
+ * not rate limited */
+static void
+queue_game(client *c)
+{
+    if (c->games_left == 0) {
+        retire_client(c);
+        return;
+    } /* if */
+
+    c->state = CLIENT_IDLE;
+    if (games_per_sec <= 0) { start_game(c); }
+    else { idle_clients[num_idle++] = c; }
+}
+
+/* Starts the queued games whose time has come. Returns the milliseconds
+ * until the next one is due, or -1 if none are queued */
+static int
+start_due_games(void)
+{
+    long long now = now_ns();
+
+    while (num_idle > 0 && next_start_ns <= now) {
+        start_game(idle_clients[0]);
+        memmove(idle_clients, idle_clients + 1, sizeof(client *) * --num_idle);
+        next_start_ns += (long long)(1e9 / games_per_sec);
+        if (next_start_ns < now - 1000000000LL) { next_start_ns = now; }
+    } /* while */
+
+    if (num_idle == 0) { return -1; }
+
+    return (int)((next_start_ns - now) / 1000000) + 1;
+}
+
+/* Places a move on a client's board. Returns whether the game goes on */
+static bool
+client_place(client *c, int pos)
+{
+    board_place(&c->board, pos, c->cur_player);
+    c->cur_player = c->cur_player == 1 ? 2 : 1;
+    c->turn++;
+
+    return check_for_win(&c->board) == -1;
+}
+
+/* Plays a random move if it is the client's turn */
+static void
+play_move(client *c)
+{
+    int num_empty, legal_moves[9];
+    net_msg msg = { 0 };
+
+    if (c->cur_player != c->seat) { return; }
+
+    num_empty = get_legal_moves(&c->board, legal_moves);
+    msg.type = MSG_MOVE;
+    msg.turn = c->turn;
+    msg.pos = legal_moves[rand() % num_empty];
+
+    wait_for(c, LAT_SYNC);
+    if (net_send(c->conn, &msg) == -1) { fail_client(c); }
+    client_place(c, msg.pos);
+}
+
+/* Handles a message from the server. Returns false if it broke the
+ * protocol */
+static bool
+handle_msg(client *c, const net_msg *msg)
+{
+    int server_seat = c->seat == 0 ? 0 : 3 - c->seat;
+    bool going;
+    net_msg reply = { 0 };
+
+    switch (msg->type) {
+        case MSG_HELLO:
+            if (c->state != CLIENT_GREETING || msg->seat != server_seat) {
+                return false;
+            } /* if */
+            answered(c);
+            c->state = CLIENT_PLAYING;
+            wait_for(c, LAT_MOVE);
+            play_move(c);
+            return true;
+        case MSG_SYNC:
+            if (c->waiting != LAT_SYNC || msg->turn != c->turn - 1
+             || memcmp(&msg->board, &c->board, sizeof(board_t))) {
+                return false;
+            } /* if */
+            answered(c);
+            wait_for(c, check_for_win(&c->board) == -1 ? LAT_MOVE
+                                                       : LAT_RESULT);
+            if (c->hanging_up && c->waiting == LAT_MOVE) { hang_up(c); }
+            return true;
+        case MSG_MOVE:
+            if (c->waiting != LAT_MOVE || c->cur_player == c->seat
+             || msg->turn != c->turn
+             || board_get(&c->board, msg->pos) != 0) {
+                return false;
+            } /* if */
+            answered(c);
+
+            going = client_place(c, msg->pos);
+            reply.type = MSG_SYNC;
+            reply.turn = msg->turn;
+            reply.board = c->board;
+            net_send(c->conn, &reply);
+
+            wait_for(c, going ? LAT_MOVE : LAT_RESULT);
+            if (going) { play_move(c); }
+
+            /* A watcher has no moves of its own to hang up after */
+            if (c->hanging_up && c->seat == 0 && going) { hang_up(c); }
+            return true;
+        case MSG_RESULT:
+            if (c->waiting != LAT_RESULT
+             || msg->result != check_for_win(&c->board)) {
+                return false;
+            } /* if */
+            answered(c);
+
+            reply.type = MSG_RESULT;
+            reply.result = msg->result;
+            net_send(c->conn, &reply);
+            games_played++;
+            c->games_left--;
+            queue_game(c);
+            return true;
+        default:
+            return false;
+    } /* switch */
+}
+
+/* Reads and handles whatever the server has sent a client */
+static void
+read_client(client *c)
+{
+    net_msg msg;
+
+    net_read(c->conn);
+    while (c->state != CLIENT_DONE && net_recv(c->conn, &msg)) {
+        if (!handle_msg(c, &msg)) { fail_client(c); }
+    } /* while */
+
+    if (c->conn == NULL) { return; }
+    if (c->conn->closed && c->state != CLIENT_DONE) { fail_client(c); }
+    net_flush(c->conn);
+}
+
+/* Finishes the connect of a client once its socket turns writable */
+static void
+finish_connect(client *c)
+{
+    struct epoll_event ev = { 0 };
+
+    if (net_socket_error(c->conn->fd) != 0) {
+        fail_client(c);
+        return;
+    } /* if */
+
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.ptr = c;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->conn->fd, &ev);
+    connected++;
+    queue_game(c);
+}
+
+/* Prints the totals of the run as JSON */
+static void
+print_summary(const char *host, int port, double seconds)
+{
+    int i;
+
+    printf("{\n");
+    printf("  \"server\": \"%s:%d\",\n", host, port);
+    printf("  \"clients\": %d,\n", num_clients);
+    printf("  \"connected\": %lld,\n", connected);
+    printf("  \"errors\": %lld,\n", errors);
+    printf("  \"hangups\": %lld,\n", hangups);
+    printf("  \"games\": %lld,\n", games_played);
+    printf("  \"seconds\": %.3f,\n", seconds);
+    printf("  \"games_per_sec\": %.1f,\n",
+           seconds > 0 ? games_played / seconds : 0.0);
+    printf("  \"messages_per_sec\": %.1f,\n",
+           seconds > 0 ? messages / seconds : 0.0);
+    printf("  \"latencies\": [\n");
+    for (i = 0; i < NUM_LAT_TYPES; i++) {
+        printf("    {\n");
+        printf("      \"message\": \"%s\",\n", latency_names[i]);
+        printf("      \"count\": %llu,\n",
+               (unsigned long long)latencies[i].total);
+        printf("      \"mean_ns\": %.0f,\n", hist_mean(&latencies[i]));
+        printf("      \"p50_ns\": %llu,\n",
+               (unsigned long long)hist_percentile(&latencies[i], 50));
+        printf("      \"p99_ns\": %llu,\n",
+               (unsigned long long)hist_percentile(&latencies[i], 99));
+        printf("      \"p999_ns\": %llu,\n",
+               (unsigned long long)hist_percentile(&latencies[i], 99.9));
+        printf("      \"max_ns\": %llu\n",
+               (unsigned long long)latencies[i].max);
+        printf("    }%s\n", i == NUM_LAT_TYPES - 1 ? "" : ",");
+    } /* for */
+    printf("  ]\n");
+    printf("}\n");
+}
+
+/* Prints the command-line options */
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [--host HOST] [--port N] [--clients N] "
+            "[--games N] [--rate N] [--watch] [--bot NAME]\n"
+            "       [--hangup F]\n", prog);
+    fprintf(stderr, "  --host HOST  Server to load (default 127.0.0.1)\n");
+    fprintf(stderr, "  --port N     Port of the server (default %d)\n",
+            NET_DEFAULT_PORT);
+    fprintf(stderr, "  --clients N  Connections kept open at once (default "
+            "%d)\n", DEFAULT_CLIENTS);
+    fprintf(stderr, "  --games N    Games each connection plays (default "
+            "%d)\n", DEFAULT_GAMES);
+    fprintf(stderr, "  --rate N     Games started per second across every "
+            "connection (default: as fast as they finish)\n");
+    fprintf(stderr, "  --watch      Watch the server's bots play each other "
+            "instead of playing random moves against them\n");
+    fprintf(stderr, "  --bot NAME   Bot the server plays (default: the "
+            "server's choice)\n");
+    fprintf(stderr, "  --hangup F   Share of games (0 to 1) a client hangs up "
+            "in the middle of,\n               while the server's bot is "
+            "thinking. It plays no more games\n");
+}
+
+/* Opens many client connections to a game server, plays full games of
+ * random moves against it on one epoll event loop and prints throughput and
+ * latency percentiles per message as JSON */
+int
+main(int argc, char **argv)
+{
+    int i, n, ready, fd, timeout;
+    int port = NET_DEFAULT_PORT;
+    const char *host = "127.0.0.1";
+    long long start;
+    client *clients, *c;
+    struct epoll_event ev = { 0 }, events[MAX_EVENTS];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } /* if */
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            num_clients = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games_per_client = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            games_per_sec = atof(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--watch") == 0) { watch = true; }
+        else if (strcmp(argv[i], "--hangup") == 0 && i + 1 < argc) {
+            hangup_share = atof(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--bot") == 0 && i + 1 < argc) {
+            /* The hello asks for the bot plus one, as 0 is the server's
+             * choice */
+            bot = find_bot(argv[++i]) + 1;
+            if (bot == 0) {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+        } /* else if */
+        else {
+            usage(argv[0]);
+            return 1;
+        } /* else */
+    } /* for */
+
+    if (num_clients < 1) { num_clients = 1; }
+    if (games_per_client < 1) { games_per_client = 1; }
+
+    srand(time(NULL));
+    raise_file_limit();
+    for (i = 0; i < NUM_LAT_TYPES; i++) { hist_init(&latencies[i]); }
+
+    clients = calloc(num_clients, sizeof(client));
+    idle_clients = malloc(sizeof(client *) * num_clients);
+    epoll_fd = epoll_create1(0);
+
+    start = now_ns();
+    next_start_ns = start;
+    for (i = 0; i < num_clients; i++) {
+        c = &clients[i];
+        c->id = i;
+        c->games_left = games_per_client;
+        c->state = CLIENT_CONNECTING;
+
+        fd = net_connect(host, port);
+        if (fd == -1) {
+            fprintf(stderr, "Could not find %s\n", host);
+            return 1;
+        } /* if */
+        c->conn = net_conn_create(fd);
+        if (c->conn == NULL) {
+            fprintf(stderr, "Out of memory for client %d\n", i);
+            return 1;
+        } /* if */
+
+        ev.events = EPOLLOUT;
+        ev.data.ptr = c;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    } /* for */
+
+    while (clients_done < num_clients) {
+        timeout = start_due_games();
+        ready = epoll_wait(epoll_fd, events, MAX_EVENTS,
+                           timeout == -1 ? 100 : timeout);
+        if (ready == -1 && errno != EINTR) { break; }
+
+        for (n = 0; n < ready; n++) {
+            c = events[n].data.ptr;
+            if (c->state == CLIENT_DONE) { continue; }
+
+            if (c->state == CLIENT_CONNECTING) { finish_connect(c); }
+            else { read_client(c); }
+        } /* for */
+    } /* while */
+
+    print_summary(host, port, (now_ns() - start) / 1e9);
+
+    for (i = 0; i < num_clients; i++) { net_conn_destroy(clients[i].conn); }
+    free(clients);
+    free(idle_clients);
+    close(epoll_fd);
+
+    return errors > 0 ? 1 : 0;
+}
+/* EOF */
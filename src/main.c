@@ -1,17 +1,151 @@
-#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mnk.h"
+#include "net.h"
+#include "oracle.h"
+#include "pool.h"
+#include "precache.h"
+#include "tui.h"
+
+/* Prints the command-line options */
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [--stats] [--size WxH] [--k K] [--time-ms N] "
+            "[--threads N] [--cold] [--connect HOST] [--port N]\n", prog);
+    fprintf(stderr, "  --size WxH  Play on a W by H board (up to %dx%d)\n",
+            MNK_MAX_SIDE, MNK_MAX_SIDE);
+    fprintf(stderr, "  --k K       Marks in a row needed to win\n");
+    fprintf(stderr, "  --time-ms N Time the bot thinks per move on these "
+            "boards (default %d)\n", MNK_DEFAULT_BUDGET_MS);
+    fprintf(stderr, "  --threads N Threads the bots search on (default 1)\n");
+    fprintf(stderr, "  --cold      Start the cache bots empty and do not save "
+            "their caches\n");
+    fprintf(stderr, "  --connect HOST  Connect to the remote player instead "
+            "of waiting for them\n");
+    fprintf(stderr, "  --port N    Port of the remote player (default %d)\n",
+            NET_DEFAULT_PORT);
+    fprintf(stderr, "Or, without the game, print the best moves of a "
+            "position as JSON:\n");
+    fprintf(stderr, "  %s --board \"XO X  O  \" [--to-move X|O] "
+            "[--engine NAME]\n", prog);
+    fprintf(stderr, "  %s --stdin [--engine NAME]  (one board per line)\n",
+            prog);
+    fprintf(stderr, "  Engines: easy, medium, minimax, cache, fastcache, "
+            "ab_pruning (ab),\n  precache (default), lazy_smp\n");
+}
 
 int
-main(void)
+main(int argc, char **argv)
 {
-    int status;
+    int i, status;
+    int width = 3, height = 3, k = 0, engine = BOT_PRECACHE;
+    bool use_mnk = false, use_snapshots = true, use_stdin = false;
+    const char *board_text = NULL, *to_move = NULL;
     game g;
+    mnk_board board;
 
-    init_ncurses();
     init_game(&g);
-    set_players(g.players);
-    set_player_moves(g.players, g.player_move_funcptr);
-    status = game_loop(&g);
-    print_results(status);
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) { g.show_stats = true; }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2) {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+            use_mnk = true;
+        } /* else if */
+        else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+            k = atoi(argv[++i]);
+            use_mnk = true;
+        } /* else if */
+        else if (strcmp(argv[i], "--time-ms") == 0 && i + 1 < argc) {
+            mnk_time_budget_ms = atol(argv[++i]);
+            if (mnk_time_budget_ms < 1) { mnk_time_budget_ms = 1; }
+        } /* else if */
+        else if (strcmp(argv[i], "--cold") == 0) { use_snapshots = false; }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            search_threads = atoi(argv[++i]);
+            if (search_threads < 1) { search_threads = 1; }
+        } /* else if */
+        else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            remote_host = argv[++i];
+        } /* else if */
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            remote_port = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            board_text = argv[++i];
+        } /* else if */
+        else if (strcmp(argv[i], "--to-move") == 0 && i + 1 < argc) {
+            to_move = argv[++i];
+        } /* else if */
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            engine = find_bot(argv[++i]);
+            if (engine == -1) {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+        } /* else if */
+        else if (strcmp(argv[i], "--stdin") == 0) { use_stdin = true; }
+        else {
+            usage(argv[0]);
+            return 1;
+        } /* else */
+    } /* for */
+
+    /* Answers positions without ncurses, menus or any table the engine does
+     * not use, so that scripts can call it many times a second */
+    if (board_text != NULL || use_stdin) {
+        if (engine == BOT_PRECACHE) { precache_load(PRECACHE_PATH); }
+        status = use_stdin ? oracle_stream(stdin, engine, stdout)
+                           : oracle_answer(board_text, to_move, engine,
+                                           stdout);
+        free_caches();
+        mnk_free_cache();
+        precache_unload();
+        return status == 0 ? 0 : 1;
+    } /* if */
+
+    /* Defaults to the shorter side, but no more than five in a row */
+    if (k == 0) {
+        k = width < height ? width : height;
+        if (k > 5) { k = 5; }
+    } /* if */
+
+    if (use_mnk && mnk_init(&board, width, height, k) != 0) {
+        fprintf(stderr, "Unsupported board: %dx%d with %d in a row\n", width,
+                height, k);
+        return 1;
+    } /* if */
+
+    /* A missing file is fine, the precache bot solves the table itself */
+    precache_load(PRECACHE_PATH);
+    if (use_snapshots) { load_caches(); }
+    init_ncurses();
+
+    if (use_mnk) {
+        set_players(g.players, false);
+        status = mnk_game_loop(&g, &board);
+        print_results(status, mnk_footer_row(&board) + 3);
+    } /* if */
+    else {
+        set_players(g.players, true);
+        set_player_moves(g.players, g.player_move_funcptr);
+        status = game_loop(&g);
+        close_connection(&g.board, status);
+        print_results(status, RESULTS_ROW);
+
+        /* The next game starts with everything this one searched */
+        if (use_snapshots) { save_caches(); }
+    } /* else */
+
+    free_caches();
+    mnk_free_cache();
+    precache_unload();
 
     return 0;
 }
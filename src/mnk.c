@@ -0,0 +1,789 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashtable.h"
+#include "mnk.h"
+#include "order.h"
+#include "pool.h"
+#include "stats.h"
+
+/* Steps of the 4 line directions: across, down, down-right and down-left */
+static const int line_dx[4] = { 1, 0, 1, -1 };
+static const int line_dy[4] = { 0, 1, 1, 1 };
+
+static uint64_t zobrist[2][MNK_MAX_SQUARES];
+static pthread_once_t zobrist_once = PTHREAD_ONCE_INIT;
+
+static ht_t *mnk_cache = NULL;
+static pthread_once_t mnk_cache_once = PTHREAD_ONCE_INIT;
+
+long mnk_time_budget_ms = MNK_DEFAULT_BUDGET_MS;
+
+typedef struct search_ctx_t search_ctx;
+
+/* The state of one search. deadline_ns is 0 when the search has no deadline.
+ * pool is where the root moves are split, or NULL to search them in turn.
+ * Lazy SMP helpers rotate their root moves by rotation, so that they start
+ * on different moves, and give up once stop is set. order is the move
+ * ordering state, which only the thread running the search may touch */
+struct search_ctx_t
+{
+    long long deadline_ns;
+    unsigned long nodes;
+    bool aborted;
+    pool_t *pool;
+    int rotation;
+    const bool *stop;
+    move_order *order;
+};
+
+typedef struct root_job_t root_job;
+
+/* A root move handed to a search pool worker. The workers share the best
+ * score so far through alpha, so later moves still get a narrowed window */
+struct root_job_t
+{
+    mnk_board board;
+    int move;
+    int player;
+    int depth;
+    long long deadline_ns;
+    int *alpha;
+    int alpha_start;
+    int score;
+    bool aborted;
+    search_stats stats;
+    move_order order;
+};
+
+typedef struct smp_job_t smp_job;
+
+/* A Lazy SMP helper, which searches the same board as the main thread */
+struct smp_job_t
+{
+    mnk_board board;
+    int player;
+    int id;
+    long long deadline_ns;
+    const bool *stop;
+    search_stats stats;
+    move_order order;
+};
+
+/* Advances a splitmix64 generator, which seeds the Zobrist keys */
+static uint64_t
+splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/* Fills in the Zobrist keys from a fixed seed */
+static void
+init_zobrist(void)
+{
+    int i;
+    uint64_t state = 0x7474745A6F6272ULL;
+
+    for (i = 0; i < MNK_MAX_SQUARES; i++) {
+        zobrist[0][i] = splitmix64(&state);
+        zobrist[1][i] = splitmix64(&state);
+    } /* for */
+}
+
+/* Initializes an empty m,n,k board */
+int
+mnk_init(mnk_board *board, int width, int height, int k)
+{
+    uint64_t dims;
+
+    if (width < 1 || width > MNK_MAX_SIDE || height < 1
+     || height > MNK_MAX_SIDE || k < 1 || (k > width && k > height)) {
+        return -1;
+    } /* if */
+
+    pthread_once(&zobrist_once, init_zobrist);
+
+    memset(board, 0, sizeof(*board));
+    board->width = width;
+    board->height = height;
+    board->k = k;
+    board->num_squares = width * height;
+
+    /* Salts the hash with the rules so that boards of different games never
+     * share cache entries */
+    dims = (uint64_t)width << 16 | height << 8 | k;
+    board->hash = splitmix64(&dims);
+
+    return 0;
+}
+
+/* Gets the owner of a square on the board */
+int
+mnk_get(const mnk_board *board, int pos)
+{
+    uint64_t bit = 1ULL << (pos & 63);
+
+    if (board->masks[0][pos >> 6] & bit) { return 1; }
+    if (board->masks[1][pos >> 6] & bit) { return 2; }
+
+    return 0;
+}
+
+/* Gets the heuristic worth of a window holding only one player's marks */
+static int
+window_worth(int marks)
+{
+    return marks * marks * marks;
+}
+
+/* Adds or removes a mark in the counts of every window through its square,
+ * adjusting the heuristic sums of both players */
+static void
+update_windows(mnk_board *board, int pos, int player, int delta)
+{
+    int dir, i, sx, sy, ex, ey, w, mine, theirs;
+    int p = player - 1, o = 2 - player;
+    int px = pos % board->width, py = pos / board->width;
+
+    for (dir = 0; dir < 4; dir++) {
+        for (i = 0; i < board->k; i++) {
+            sx = px - i * line_dx[dir];
+            sy = py - i * line_dy[dir];
+            ex = sx + (board->k - 1) * line_dx[dir];
+            ey = sy + (board->k - 1) * line_dy[dir];
+            if (sx < 0 || sx >= board->width || sy < 0 || ex < 0
+             || ex >= board->width || ey >= board->height) {
+                continue;
+            } /* if */
+
+            w = dir * board->num_squares + sy * board->width + sx;
+            mine = board->counts[p][w];
+            theirs = board->counts[o][w];
+            if (delta < 0) { mine--; }
+
+            /* A window with the other player's marks is worth nothing to us,
+             * and our first mark in it takes away its worth to them */
+            if (theirs == 0) {
+                board->eval[p] += delta * (window_worth(mine + 1)
+                                         - window_worth(mine));
+            } /* if */
+            else if (mine == 0) {
+                board->eval[o] -= delta * window_worth(theirs);
+            } /* else if */
+
+            board->counts[p][w] += delta;
+        } /* for */
+    } /* for */
+}
+
+/* Places a player's mark on an empty square */
+void
+mnk_place(mnk_board *board, int pos, int player)
+{
+    update_windows(board, pos, player, 1);
+    board->masks[player - 1][pos >> 6] |= 1ULL << (pos & 63);
+    board->hash ^= zobrist[player - 1][pos];
+    board->num_marks++;
+}
+
+/* Removes a player's mark from the board */
+void
+mnk_remove(mnk_board *board, int pos, int player)
+{
+    update_windows(board, pos, player, -1);
+    board->masks[player - 1][pos >> 6] &= ~(1ULL << (pos & 63));
+    board->hash ^= zobrist[player - 1][pos];
+    board->num_marks--;
+}
+
+/* Checks whether the mark on a square is part of k in a row */
+bool
+mnk_is_win(const mnk_board *board, int pos, int player)
+{
+    int dir, step, run, x, y;
+    int px = pos % board->width, py = pos / board->width;
+
+    for (dir = 0; dir < 4; dir++) {
+        run = 1;
+
+        /* Counts the marks in a row on both sides of the square */
+        for (step = -1; step <= 1; step += 2) {
+            x = px + step * line_dx[dir];
+            y = py + step * line_dy[dir];
+            while (x >= 0 && x < board->width && y >= 0 && y < board->height
+                && mnk_get(board, y * board->width + x) == player) {
+                run++;
+                x += step * line_dx[dir];
+                y += step * line_dy[dir];
+            } /* while */
+        } /* for */
+
+        if (run >= board->k) { return true; }
+    } /* for */
+
+    return false;
+}
+
+/* Checks the board for termination after a move */
+int
+mnk_check_for_win(const mnk_board *board, int last_pos)
+{
+    int player = mnk_get(board, last_pos);
+
+    if (player != 0 && mnk_is_win(board, last_pos, player)) { return player; }
+    if (board->num_marks == board->num_squares) { return 0; }
+
+    return -1;
+}
+
+/* Gets all of the empty squares of the board */
+int
+mnk_legal_moves(const mnk_board *board, int *legal_moves)
+{
+    int w, pos;
+    int j = 0;
+    uint64_t empty;
+
+    for (w = 0; w < MNK_WORDS; w++) {
+        empty = ~(board->masks[0][w] | board->masks[1][w]);
+        while (empty != 0) {
+            pos = w * 64 + __builtin_ctzll(empty);
+            if (pos >= board->num_squares) { break; }
+            legal_moves[j++] = pos;
+            empty &= empty - 1;
+        } /* while */
+    } /* for */
+
+    return j;
+}
+
+/* Gets the candidate moves of a search. Small boards try every empty square,
+ * larger ones only the empty squares next to a mark, since a move far from
+ * every mark is almost never best */
+static int
+candidate_moves(const mnk_board *board, int *moves)
+{
+    int i, j, dx, dy, x, y, num_legal;
+    int num_moves = 0;
+    int legal_moves[MNK_MAX_SQUARES];
+    bool near;
+
+    num_legal = mnk_legal_moves(board, legal_moves);
+
+    if (board->num_squares <= 16 || board->num_marks == 0) {
+        /* The center is the only opening worth trying on a large board */
+        if (board->num_squares > 16) {
+            moves[0] = board->height / 2 * board->width + board->width / 2;
+            return 1;
+        } /* if */
+        memcpy(moves, legal_moves, sizeof(int) * num_legal);
+        return num_legal;
+    } /* if */
+
+    for (i = 0; i < num_legal; i++) {
+        near = false;
+        for (j = 0; j < 9 && !near; j++) {
+            dx = j % 3 - 1;
+            dy = j / 3 - 1;
+            x = legal_moves[i] % board->width + dx;
+            y = legal_moves[i] / board->width + dy;
+            if (x < 0 || x >= board->width || y < 0 || y >= board->height) {
+                continue;
+            } /* if */
+            near = mnk_get(board, y * board->width + x) != 0;
+        } /* for */
+        if (near) { moves[num_moves++] = legal_moves[i]; }
+    } /* for */
+
+    return num_moves;
+}
+
+/* Scores the board for a player without searching */
+int
+mnk_evaluate(const mnk_board *board, int player)
+{
+    int score = board->eval[player - 1] - board->eval[2 - player];
+
+    if (score > MNK_EVAL_MAX) { return MNK_EVAL_MAX; }
+    if (score < -MNK_EVAL_MAX) { return -MNK_EVAL_MAX; }
+
+    return score;
+}
+
+/* Checks the deadline and the stop flag every so often. Once either is hit,
+ * every search frame unwinds without storing anything */
+static bool
+out_of_time(search_ctx *ctx)
+{
+    if ((++ctx->nodes & 1023) == 0
+     && ((ctx->deadline_ns != 0 && now_ns() >= ctx->deadline_ns)
+      || (ctx->stop != NULL && __atomic_load_n(ctx->stop, __ATOMIC_RELAXED)))) {
+        ctx->aborted = true;
+    } /* if */
+
+    return ctx->aborted;
+}
+
+/* Sets the static priority of every square to the number of windows through
+ * it, which favours the center, where a mark takes part in the most lines */
+static void
+square_priorities(const mnk_board *board, int *priority)
+{
+    int pos, d, t, x, y;
+
+    for (pos = 0; pos < board->num_squares; pos++) {
+        priority[pos] = 0;
+        for (d = 0; d < 4; d++) {
+            for (t = 0; t < board->k; t++) {
+                /* The window starting t squares back from pos */
+                x = pos % board->width - t * line_dx[d];
+                y = pos / board->width - t * line_dy[d];
+                if (x >= 0 && x < board->width && y >= 0 && y < board->height
+                 && x + (board->k - 1) * line_dx[d] >= 0
+                 && x + (board->k - 1) * line_dx[d] < board->width
+                 && y + (board->k - 1) * line_dy[d] < board->height) {
+                    priority[pos]++;
+                } /* if */
+            } /* for */
+        } /* for */
+    } /* for */
+}
+
+/* Starts the move ordering of a search of the board */
+static void
+init_order(move_order *order, const mnk_board *board)
+{
+    int priority[MNK_MAX_SQUARES];
+
+    square_priorities(board, priority);
+    order_init(order, priority, board->num_squares);
+}
+
+/* Converts a score into the table's form, where a win counts its plies from
+ * the board it was stored for rather than from the root of the search, so
+ * that the entry holds wherever the board comes up again */
+static int
+score_to_tt(int score, int ply)
+{
+    if (score >= MNK_WIN_MIN) { return score + ply; }
+    if (score <= -MNK_WIN_MIN) { return score - ply; }
+
+    return score;
+}
+
+/* Converts a score from the table's form back into one from the root */
+static int
+score_from_tt(int score, int ply)
+{
+    if (score >= MNK_WIN_MIN) { return score - ply; }
+    if (score <= -MNK_WIN_MIN) { return score + ply; }
+
+    return score;
+}
+
+/* Gets the negamax score of the board for the player to move */
+static int
+negamax(search_ctx *ctx, mnk_board *board, int player, int depth, int alpha,
+        int beta, int ply)
+{
+    int i, score, num_moves;
+    int opponent = player == 1 ? 2 : 1;
+    int alpha_orig, best_score = -MNK_WIN - 1, best_move = HT_NO_MOVE;
+    int tt_move = HT_NO_MOVE, tt_score;
+    int moves[MNK_MAX_SQUARES];
+    bool found = false;
+    entry_t entry;
+
+    if (out_of_time(ctx)) { return 0; }
+
+    STAT_INC(nodes);
+    STAT_PLY(ply);
+
+    /* Mate distance pruning: the player to move wins on their next mark at
+     * best, and loses on the opponent's next mark at worst */
+    if (alpha < -(MNK_WIN - ply - 2)) { alpha = -(MNK_WIN - ply - 2); }
+    if (beta > MNK_WIN - ply - 1) { beta = MNK_WIN - ply - 1; }
+    if (alpha >= beta) { return alpha; }
+    alpha_orig = alpha;
+
+    found = ht_get(mnk_cache, board->hash, &entry);
+    STAT_INC(probes);
+    if (found) {
+        /* Even a shallower entry knows a good move to try first */
+        tt_move = entry.move;
+        tt_score = score_from_tt(entry.score, ply);
+
+        /* A bound only settles the board if it falls outside the window.
+         * Narrowing the window with it instead would store a score that
+         * failed against the narrowed window as exact */
+        if (entry.depth >= depth
+         && (entry.flag == HT_EXACT
+          || (entry.flag == HT_LOWER && tt_score >= beta)
+          || (entry.flag == HT_UPPER && tt_score <= alpha))) {
+            STAT_INC(hits);
+            return tt_score;
+        } /* if */
+    } /* if */
+
+    if (depth == 0) {
+        STAT_INC(terminals);
+        return mnk_evaluate(board, player);
+    } /* if */
+
+    num_moves = candidate_moves(board, moves);
+    if (num_moves == 0) { return 0; }
+    order_moves(ctx->order, moves, num_moves,
+                tt_move == HT_NO_MOVE ? -1 : tt_move, ply, player);
+
+    for (i = 0; i < num_moves; i++) {
+        mnk_place(board, moves[i], player);
+
+        if (mnk_is_win(board, moves[i], player)) {
+            score = MNK_WIN - ply - 1;
+        } /* if */
+        else if (board->num_marks == board->num_squares) { score = 0; }
+        else {
+            score = -negamax(ctx, board, opponent, depth - 1, -beta, -alpha,
+                             ply + 1);
+        } /* else */
+
+        mnk_remove(board, moves[i], player);
+
+        if (ctx->aborted) { return 0; }
+
+        if (score > best_score) {
+            best_score = score;
+            best_move = moves[i];
+        } /* if */
+        if (score > alpha) { alpha = score; }
+        if (alpha >= beta) {
+            STAT_INC(cutoffs);
+            order_cutoff(ctx->order, moves[i], ply, player, depth);
+            break;
+        } /* if */
+    } /* for */
+
+    STAT_INC(stores);
+    ht_set(mnk_cache, board->hash, score_to_tt(best_score, ply),
+           best_score <= alpha_orig ? HT_UPPER
+           : best_score >= beta ? HT_LOWER : HT_EXACT,
+           best_move, depth);
+
+    return best_score;
+}
+
+/* Scores one root move on a worker thread */
+static void
+run_root_job(void *arg)
+{
+    root_job *job = arg;
+    int opponent = job->player == 1 ? 2 : 1;
+    int alpha, beta = MNK_WIN + 1;
+    search_ctx ctx = { job->deadline_ns, 0, false, NULL, 0, NULL,
+                       &job->order };
+
+    stats_reset();
+    alpha = __atomic_load_n(job->alpha, __ATOMIC_RELAXED);
+    job->alpha_start = alpha;
+
+    mnk_place(&job->board, job->move, job->player);
+    if (mnk_is_win(&job->board, job->move, job->player)) {
+        job->score = MNK_WIN - 1;
+    } /* if */
+    else if (job->board.num_marks == job->board.num_squares) {
+        job->score = 0;
+    } /* else if */
+    else {
+        job->score = -negamax(&ctx, &job->board, opponent, job->depth - 1,
+                              -beta, -alpha, 1);
+    } /* else */
+
+    /* Raises the shared alpha for the jobs that have yet to start */
+    while (!ctx.aborted && job->score > alpha
+        && !__atomic_compare_exchange_n(job->alpha, &alpha, job->score, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        continue;
+    } /* while */
+
+    job->aborted = ctx.aborted;
+    job->stats = stats;
+}
+
+/* Searches every root move on the search pool, with one job of jobs per
+ * move. A move that failed low against the alpha it started with only has an
+ * upper bound, so only moves that beat their starting alpha can be picked */
+static int
+search_root_parallel(search_ctx *ctx, pool_t *pool, root_job *jobs,
+                     mnk_board *board, int player, int depth,
+                     const int *moves, int num_moves, int *best_move)
+{
+    int i;
+    int alpha = -MNK_WIN - 1, best_score = -MNK_WIN - 1;
+    pool_group group = { 0 };
+
+    for (i = 0; i < num_moves; i++) {
+        jobs[i].board = *board;
+        jobs[i].move = moves[i];
+        jobs[i].player = player;
+        jobs[i].depth = depth;
+        jobs[i].deadline_ns = ctx->deadline_ns;
+        jobs[i].alpha = &alpha;
+        jobs[i].order = *ctx->order;
+        pool_submit(pool, &group, run_root_job, &jobs[i]);
+    } /* for */
+
+    pool_wait(pool, &group);
+
+    for (i = 0; i < num_moves; i++) {
+        stats_add(&stats, &jobs[i].stats);
+        if (jobs[i].aborted) { ctx->aborted = true; }
+
+        if (jobs[i].score > jobs[i].alpha_start
+         && jobs[i].score > best_score) {
+            best_score = jobs[i].score;
+            *best_move = moves[i];
+        } /* if */
+    } /* for */
+
+    return best_score;
+}
+
+/* Creates the transposition table shared by every m,n,k search. It keeps
+ * its size: a deep search stores far more positions than any table holds,
+ * so replacing entries bounds its memory where growing would not */
+static void
+create_mnk_cache(void)
+{
+    mnk_cache = ht_create(MNK_CACHE_SIZE, 0);
+}
+
+/* Rotates every move but the first, which is the one the table suggested */
+static void
+rotate_moves(int *moves, int num_moves, int rotation)
+{
+    int i;
+    int rotated[MNK_MAX_SQUARES];
+
+    if (num_moves < 3) { return; }
+
+    for (i = 1; i < num_moves; i++) {
+        rotated[i] = moves[1 + (i - 1 + rotation) % (num_moves - 1)];
+    } /* for */
+    for (i = 1; i < num_moves; i++) { moves[i] = rotated[i]; }
+}
+
+/* Searches every root move to a fixed depth, trying first_move first */
+static int
+search_root(search_ctx *ctx, mnk_board *board, int player, int depth,
+            int first_move, int *best_move)
+{
+    int i, score, num_moves;
+    int opponent = player == 1 ? 2 : 1;
+    int alpha = -MNK_WIN - 1, beta = MNK_WIN + 1;
+    int moves[MNK_MAX_SQUARES];
+    root_job *jobs = NULL;
+
+    pthread_once(&mnk_cache_once, create_mnk_cache);
+
+    num_moves = candidate_moves(board, moves);
+    order_moves(ctx->order, moves, num_moves, first_move, 0, player);
+    if (ctx->rotation > 0) { rotate_moves(moves, num_moves, ctx->rotation); }
+    *best_move = moves[0];
+
+    if (ctx->pool != NULL && num_moves > 1) {
+        jobs = malloc(sizeof(root_job) * num_moves);
+    } /* if */
+
+    /* Without memory for the jobs, the moves are searched here one by one */
+    if (jobs != NULL) {
+        score = search_root_parallel(ctx, ctx->pool, jobs, board, player,
+                                     depth, moves, num_moves, best_move);
+        free(jobs);
+        return score;
+    } /* if */
+
+    for (i = 0; i < num_moves; i++) {
+        mnk_place(board, moves[i], player);
+
+        if (mnk_is_win(board, moves[i], player)) { score = MNK_WIN - 1; }
+        else if (board->num_marks == board->num_squares) { score = 0; }
+        else {
+            score = -negamax(ctx, board, opponent, depth - 1, -beta, -alpha,
+                             1);
+        } /* else */
+
+        mnk_remove(board, moves[i], player);
+
+        if (ctx->aborted) { break; }
+
+        if (score > alpha) {
+            alpha = score;
+            *best_move = moves[i];
+        } /* if */
+    } /* for */
+
+    return alpha;
+}
+
+/* Searches the board with negamax alpha-beta and a transposition table */
+int
+mnk_search(mnk_board *board, int player, int depth, int *best_move)
+{
+    move_order order;
+    search_ctx ctx = { 0, 0, false, search_pool(), 0, NULL, &order };
+
+    init_order(&order, board);
+
+    return search_root(&ctx, board, player, depth, -1, best_move);
+}
+
+/* Deepens the search one ply at a time from first_depth until the deadline,
+ * the end of the game or a proven win or loss */
+static int
+deepen(search_ctx *ctx, mnk_board *board, int player, int first_depth,
+       long long deadline, int *best_move, int *depth_reached)
+{
+    int depth, score, move;
+    int best_score = 0;
+    int num_empty = board->num_squares - board->num_marks;
+
+    *best_move = -1;
+    *depth_reached = 0;
+
+    for (depth = first_depth; depth <= num_empty; depth++) {
+        /* Depth 1 always finishes, so that there is always a move */
+        ctx->deadline_ns = depth == 1 ? 0 : deadline;
+        score = search_root(ctx, board, player, depth, *best_move, &move);
+
+        /* A search cut short by the deadline may not have seen the best
+         * move yet, so the last completed depth decides */
+        if (ctx->aborted) { break; }
+
+        *best_move = move;
+        *depth_reached = depth;
+        best_score = score;
+
+        /* Deeper searches cannot change a win or loss proven within the
+         * depth searched. One further away may have come from the table,
+         * and a deeper search could still find a faster win */
+        if (abs(score) >= MNK_WIN_MIN && MNK_WIN - abs(score) <= depth) {
+            break;
+        } /* if */
+        if (now_ns() >= deadline) { break; }
+    } /* for */
+
+    return best_score;
+}
+
+/* Searches the board with iterative deepening until the budget runs out */
+int
+mnk_search_timed(mnk_board *board, int player, long budget_ms,
+                 int *best_move, int *depth_reached)
+{
+    long long deadline = now_ns() + budget_ms * 1000000LL;
+    move_order order;
+    search_ctx ctx = { 0, 0, false, search_pool(), 0, NULL, &order };
+
+    init_order(&order, board);
+
+    return deepen(&ctx, board, player, 1, deadline, best_move,
+                  depth_reached);
+}
+
+/* Runs one Lazy SMP helper until the main search stops it. Odd helpers
+ * start a ply deeper than the main search, so that the table gets deeper
+ * entries sooner */
+static void
+run_smp_job(void *arg)
+{
+    smp_job *job = arg;
+    int move, depth_reached;
+    search_ctx ctx = { 0, 0, false, NULL, job->id, job->stop, &job->order };
+
+    stats_reset();
+    deepen(&ctx, &job->board, job->player, 1 + job->id % 2, job->deadline_ns,
+           &move, &depth_reached);
+    job->stats = stats;
+}
+
+/* Searches the board with iterative deepening on every search thread. The
+ * threads search the same board and only share the transposition table */
+int
+mnk_search_smp(mnk_board *board, int player, long budget_ms, int *best_move,
+               int *depth_reached)
+{
+    int i, score;
+    int num_helpers = search_threads - 1;
+    long long deadline = now_ns() + budget_ms * 1000000LL;
+    bool stop = false;
+    pool_t *pool = search_pool();
+    pool_group group = { 0 };
+    move_order order;
+    search_ctx ctx = { 0, 0, false, NULL, 0, NULL, &order };
+    smp_job *jobs = NULL;
+
+    if (pool == NULL) { num_helpers = 0; }
+
+    pthread_once(&mnk_cache_once, create_mnk_cache);
+    init_order(&order, board);
+
+    /* Without memory for the helpers, the main search runs alone */
+    jobs = malloc(sizeof(smp_job) * (num_helpers + 1));
+    if (jobs == NULL) { num_helpers = 0; }
+    for (i = 0; i < num_helpers; i++) {
+        jobs[i].board = *board;
+        jobs[i].player = player;
+        jobs[i].id = i + 1;
+        jobs[i].deadline_ns = deadline;
+        jobs[i].stop = &stop;
+        jobs[i].order = order;
+        pool_submit(pool, &group, run_smp_job, &jobs[i]);
+    } /* for */
+
+    /* Only the main search picks the move. The helpers are stopped as soon
+     * as it finishes */
+    score = deepen(&ctx, board, player, 1, deadline, best_move,
+                   depth_reached);
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+
+    if (num_helpers > 0) { pool_wait(pool, &group); }
+    for (i = 0; i < num_helpers; i++) { stats_add(&stats, &jobs[i].stats); }
+
+    free(jobs);
+
+    return score;
+}
+
+/* Empties the transposition table of the m,n,k searches */
+void
+mnk_reset_cache(void)
+{
+    if (mnk_cache != NULL) { ht_reset(mnk_cache); }
+}
+
+/* Frees the transposition table of the m,n,k searches */
+void
+mnk_free_cache(void)
+{
+    ht_destroy(mnk_cache);
+    mnk_cache = NULL;
+}
+
+/* Gets a move from the m,n,k bot */
+int
+get_mnk_bot_move(mnk_board *board, int cur_player)
+{
+    int best_move, depth_reached;
+
+    mnk_search_timed(board, cur_player, mnk_time_budget_ms, &best_move,
+                     &depth_reached);
+
+    return best_move;
+}
+/* EOF */
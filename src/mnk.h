@@ -0,0 +1,193 @@
+#ifndef MNK_H
+#define MNK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Largest supported width or height of an m,n,k board */
+#define MNK_MAX_SIDE 15
+#define MNK_MAX_SQUARES (MNK_MAX_SIDE * MNK_MAX_SIDE)
+
+/* 64-bit words in each player's bitset */
+#define MNK_WORDS ((MNK_MAX_SQUARES + 63) / 64)
+
+/* Score of a won position, less the number of plies from the root of the
+ * search to the winning mark, so that the search plays the fastest win and
+ * the slowest loss. Any score of at least MNK_WIN_MIN is a proven win.
+ * Heuristic scores always stay below MNK_EVAL_MAX */
+#define MNK_WIN 30000
+#define MNK_WIN_MIN (MNK_WIN - MNK_MAX_SQUARES)
+#define MNK_EVAL_MAX 20000
+
+/* Time the m,n,k bot spends on each move unless told otherwise */
+#define MNK_DEFAULT_BUDGET_MS 50
+
+/* Slots in the transposition table of the m,n,k search (4 MiB) */
+#define MNK_CACHE_SIZE (1 << 18)
+
+typedef struct mnk_board_t mnk_board;
+typedef int (*mnk_move_func)(mnk_board *, int);
+
+/* Time the m,n,k bot spends on each move, in milliseconds */
+extern long mnk_time_budget_ms;
+
+/* A width x height board won by k marks in a row. Square i is at row
+ * i / width, column i % width, and is bit i of each player's bitset.
+ *
+ * A window is a line of k squares, identified by its direction (across, down,
+ * down-right, down-left) times num_squares plus the square it starts on.
+ * counts holds each player's marks in every window and eval each player's
+ * heuristic score summed over the windows, so that both, like the Zobrist
+ * hash, are kept up to date as marks are placed instead of recomputed */
+struct mnk_board_t
+{
+    int width;
+    int height;
+    int k;
+    int num_squares;
+    int num_marks;
+    uint64_t masks[2][MNK_WORDS];
+    uint64_t hash;
+    int eval[2];
+    uint8_t counts[2][4 * MNK_MAX_SQUARES];
+};
+
+/**
+ * Initializes an empty m,n,k board
+ * @param board The board
+ * @param width The number of columns (1 to MNK_MAX_SIDE)
+ * @param height The number of rows (1 to MNK_MAX_SIDE)
+ * @param k The number of marks in a row needed to win
+ * @return 0 on success, -1 if the dimensions are not supported
+ */
+int mnk_init(mnk_board *board, int width, int height, int k);
+
+/**
+ * Gets the owner of a square on the board
+ * @param board The board
+ * @param pos The position of the square
+ * @return 0 if the square is empty, 1/2 if player 1/2 owns it
+ */
+int mnk_get(const mnk_board *board, int pos);
+
+/**
+ * Places a player's mark on an empty square
+ * @param board The board
+ * @param pos The position of the square
+ * @param player The player whose mark is placed
+ */
+void mnk_place(mnk_board *board, int pos, int player);
+
+/**
+ * Removes a player's mark from the board, undoing mnk_place
+ * @param board The board
+ * @param pos The position of the square
+ * @param player The player whose mark is removed
+ */
+void mnk_remove(mnk_board *board, int pos, int player);
+
+/**
+ * Checks whether the mark on a square is part of k in a row. Only the lines
+ * through that square are scanned, so checking the last move is O(k)
+ * @param board The board
+ * @param pos The position of the square
+ * @param player The player who owns the square
+ * @return Whether the player has k in a row through the square
+ */
+bool mnk_is_win(const mnk_board *board, int pos, int player);
+
+/**
+ * Checks the board for termination after a move
+ * @param board The board
+ * @param last_pos The position of the last move
+ * @return The termination state of the game. -1 if the game should continue, 0
+ * if the game is tied, 1/2 if player 1/2 won
+ */
+int mnk_check_for_win(const mnk_board *board, int last_pos);
+
+/**
+ * Gets all of the empty squares of the board
+ * @param board The board
+ * @param legal_moves An array of at least board->num_squares ints for the
+ * positions of legal moves. Passed in as an out value
+ * @return The number of legal moves
+ */
+int mnk_legal_moves(const mnk_board *board, int *legal_moves);
+
+/**
+ * Scores the board for a player without searching, from the windows of k
+ * squares that only one player has marks in. Each such window is worth the
+ * cube of its marks. O(1), since the sums are kept up to date by mnk_place
+ * @param board The board
+ * @param player The player to score for
+ * @return A score between -MNK_EVAL_MAX and MNK_EVAL_MAX
+ */
+int mnk_evaluate(const mnk_board *board, int player);
+
+/**
+ * Searches the board with negamax alpha-beta and a transposition table
+ * @param board The board. Restored to its original state on return
+ * @param player The player to move
+ * @param depth The number of plies to search
+ * @param best_move The best move found. Passed in as an out value
+ * @return The score of the board for the player to move
+ */
+int mnk_search(mnk_board *board, int player, int depth, int *best_move);
+
+/**
+ * Searches the board with iterative deepening: depth 1, 2, 3 and so on until
+ * the budget runs out, the game is searched to the end or a win or loss is
+ * proven. Each depth tries the best moves stored by the last one first. A
+ * depth cut short by the deadline is thrown away, except that depth 1 always
+ * finishes
+ * @param board The board. Restored to its original state on return
+ * @param player The player to move
+ * @param budget_ms The time to search for, in milliseconds
+ * @param best_move The best move of the last completed depth. Passed in as an
+ * out value
+ * @param depth_reached The last completed depth. Passed in as an out value
+ * @return The score of the board for the player to move at that depth
+ */
+int mnk_search_timed(mnk_board *board, int player, long budget_ms,
+                     int *best_move, int *depth_reached);
+
+/**
+ * Searches the board like mnk_search_timed, with Lazy SMP: search_threads - 1
+ * helper threads search the same board at the same time and only share the
+ * transposition table, which fills it with entries that speed up the main
+ * search. Every other helper starts a ply deeper, and each one tries the root
+ * moves in a different order. The helpers stop when the main search does
+ * @param board The board. Restored to its original state on return
+ * @param player The player to move
+ * @param budget_ms The time to search for, in milliseconds
+ * @param best_move The best move of the main search's last completed depth.
+ * Passed in as an out value
+ * @param depth_reached That depth. Passed in as an out value
+ * @return The score of the board for the player to move at that depth
+ */
+int mnk_search_smp(mnk_board *board, int player, long budget_ms,
+                   int *best_move, int *depth_reached);
+
+/**
+ * Empties the transposition table of the m,n,k searches in O(1). No search
+ * may be running meanwhile
+ */
+void mnk_reset_cache(void);
+
+/**
+ * Frees the transposition table of the m,n,k searches. Call at shutdown; no
+ * search may run afterwards
+ */
+void mnk_free_cache(void);
+
+/**
+ * Gets a move from the m,n,k bot, which runs mnk_search_timed for
+ * mnk_time_budget_ms
+ * @param board The board
+ * @param cur_player The player whose turn it is
+ * @return The position of the bot's move
+ */
+int get_mnk_bot_move(mnk_board *board, int cur_player);
+
+#endif
+/* EOF */
@@ -0,0 +1,353 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net.h"
+
+/* Gets the length of a message from its type byte, or -1 if it is unknown */
+static int
+msg_length(uint8_t type)
+{
+    switch (type) {
+        case MSG_HELLO: return 4;
+        case MSG_MOVE: return 3;
+        case MSG_SYNC: return 6;
+        case MSG_RESULT: return 2;
+        default: return -1;
+    } /* switch */
+}
+
+/* Encodes a message into its wire format */
+int
+net_encode(const net_msg *msg, uint8_t *buf)
+{
+    buf[0] = msg->type;
+
+    switch (msg->type) {
+        case MSG_HELLO:
+            buf[1] = msg->version;
+            buf[2] = msg->seat;
+            buf[3] = msg->bot;
+            break;
+        case MSG_MOVE:
+            buf[1] = msg->turn;
+            buf[2] = msg->pos;
+            break;
+        case MSG_SYNC:
+            buf[1] = msg->turn;
+            buf[2] = msg->board.masks[0] & 0xFF;
+            buf[3] = msg->board.masks[0] >> 8;
+            buf[4] = msg->board.masks[1] & 0xFF;
+            buf[5] = msg->board.masks[1] >> 8;
+            break;
+        case MSG_RESULT:
+            buf[1] = msg->result;
+            break;
+        default:
+            return -1;
+    } /* switch */
+
+    return msg_length(msg->type);
+}
+
+/* Decodes the message at the start of a buffer */
+int
+net_decode(const uint8_t *buf, size_t len, net_msg *msg)
+{
+    int length;
+
+    if (len == 0) { return 0; }
+
+    length = msg_length(buf[0]);
+    if (length == -1) { return -1; }
+    if (len < (size_t)length) { return 0; }
+
+    memset(msg, 0, sizeof(net_msg));
+    msg->type = buf[0];
+
+    switch (msg->type) {
+        case MSG_HELLO:
+            msg->version = buf[1];
+            msg->seat = buf[2];
+            msg->bot = buf[3];
+            if (msg->seat > 2 || msg->bot > NUM_BOTS) { return -1; }
+            break;
+        case MSG_MOVE:
+            msg->turn = buf[1];
+            msg->pos = buf[2];
+            if (msg->pos > 8 || msg->turn < 1 || msg->turn > 9) { return -1; }
+            break;
+        case MSG_SYNC:
+            msg->turn = buf[1];
+            msg->board.masks[0] = buf[2] | buf[3] << 8;
+            msg->board.masks[1] = buf[4] | buf[5] << 8;
+            if ((msg->board.masks[0] | msg->board.masks[1]) & ~FULL_BOARD
+             || msg->board.masks[0] & msg->board.masks[1]) { return -1; }
+            break;
+        case MSG_RESULT:
+            msg->result = buf[1];
+            if (msg->result > 2) { return -1; }
+            break;
+        default:
+            break;
+    } /* switch */
+
+    return length;
+}
+
+/* Makes a socket non-blocking and sends small messages without delay */
+static void
+set_socket_options(int fd)
+{
+    int one = 1;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/* Opens a non-blocking socket listening on every address */
+int
+net_listen(int port)
+{
+    int fd, one = 1;
+    struct sockaddr_in addr;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) { return -1; }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1
+     || listen(fd, SOMAXCONN) == -1) {
+        close(fd);
+        return -1;
+    } /* if */
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    return fd;
+}
+
+/* Accepts a pending connection without blocking */
+int
+net_accept(int listen_fd)
+{
+    int fd = accept(listen_fd, NULL, NULL);
+
+    if (fd != -1) { set_socket_options(fd); }
+
+    return fd;
+}
+
+/* Starts connecting to a host without blocking */
+int
+net_connect(const char *host, int port)
+{
+    int fd;
+    char port_str[8];
+    struct addrinfo hints, *addrs = NULL;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    if (getaddrinfo(host, port_str, &hints, &addrs) != 0) { return -1; }
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd != -1) {
+        set_socket_options(fd);
+
+        /* The result of the connect shows up later, on the socket */
+        if (connect(fd, addrs->ai_addr, addrs->ai_addrlen) == -1
+         && errno != EINPROGRESS) {
+            close(fd);
+            fd = -1;
+        } /* if */
+    } /* if */
+
+    freeaddrinfo(addrs);
+
+    return fd;
+}
+
+/* Gets the error left on a socket, such as the result of a connect */
+int
+net_socket_error(int fd)
+{
+    int error = 0;
+    socklen_t len = sizeof(error);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) {
+        return errno;
+    } /* if */
+
+    return error;
+}
+
+/* Waits on epoll until a socket is ready or the timeout runs out */
+int
+net_wait(int fd, uint32_t events, int timeout_ms)
+{
+    int ready, epoll_fd = epoll_create1(0);
+    struct epoll_event ev = { 0 };
+
+    if (epoll_fd == -1) { return -1; }
+
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        close(epoll_fd);
+        return -1;
+    } /* if */
+
+    ready = epoll_wait(epoll_fd, &ev, 1, timeout_ms);
+    close(epoll_fd);
+
+    if (ready == -1) { return errno == EINTR ? 0 : -1; }
+
+    return ready == 0 ? 0 : (int)ev.events;
+}
+
+/* Wraps a connected non-blocking socket */
+net_conn *
+net_conn_create(int fd)
+{
+    net_conn *conn = malloc(sizeof(net_conn));
+
+    if (conn == NULL) { return NULL; }
+
+    conn->fd = fd;
+    conn->epoll_fd = -1;
+    conn->closed = false;
+    conn->in_len = 0;
+    conn->out_len = 0;
+
+    return conn;
+}
+
+/* Closes the socket of a connection and frees it */
+void
+net_conn_destroy(net_conn *conn)
+{
+    if (conn == NULL) { return; }
+
+    if (conn->epoll_fd != -1) { close(conn->epoll_fd); }
+    close(conn->fd);
+    free(conn);
+}
+
+/* Queues a message and sends as much of the queue as the socket takes */
+int
+net_send(net_conn *conn, const net_msg *msg)
+{
+    if (conn->closed || conn->out_len + NET_MAX_MSG > NET_BUFFER_SIZE) {
+        return -1;
+    } /* if */
+
+    conn->out_len += net_encode(msg, conn->out + conn->out_len);
+
+    return net_flush(conn);
+}
+
+/* Sends as much of the queued output as the socket takes */
+int
+net_flush(net_conn *conn)
+{
+    ssize_t sent;
+
+    while (!conn->closed && conn->out_len > 0) {
+        sent = send(conn->fd, conn->out, conn->out_len, MSG_NOSIGNAL);
+        if (sent == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+            if (errno != EINTR) { conn->closed = true; }
+            continue;
+        } /* if */
+
+        conn->out_len -= sent;
+        memmove(conn->out, conn->out + sent, conn->out_len);
+    } /* while */
+
+    return conn->closed ? -1 : 0;
+}
+
+/* Reads whatever input has arrived */
+int
+net_read(net_conn *conn)
+{
+    ssize_t received;
+
+    while (!conn->closed && conn->in_len < NET_BUFFER_SIZE) {
+        received = recv(conn->fd, conn->in + conn->in_len,
+                        NET_BUFFER_SIZE - conn->in_len, 0);
+        if (received == 0) { conn->closed = true; }
+        else if (received == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+            if (errno != EINTR) { conn->closed = true; }
+        } /* else if */
+        else { conn->in_len += received; }
+    } /* while */
+
+    return conn->closed ? -1 : 0;
+}
+
+/* Takes the next complete message out of the input */
+bool
+net_recv(net_conn *conn, net_msg *msg)
+{
+    int length = net_decode(conn->in, conn->in_len, msg);
+
+    if (length == -1) {
+        conn->closed = true;
+        return false;
+    } /* if */
+    if (length == 0) { return false; }
+
+    conn->in_len -= length;
+    memmove(conn->in, conn->in + length, conn->in_len);
+
+    return true;
+}
+
+/* Waits on epoll until input arrives or the timeout runs out */
+int
+net_poll(net_conn *conn, int timeout_ms)
+{
+    struct epoll_event ev = { 0 };
+
+    if (conn->closed) { return -1; }
+
+    /* The socket is registered once, for input and for the end of the
+     * connection. Output is small enough to go out as soon as it is sent */
+    if (conn->epoll_fd == -1) {
+        conn->epoll_fd = epoll_create1(0);
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = conn->fd;
+        if (conn->epoll_fd == -1
+         || epoll_ctl(conn->epoll_fd, EPOLL_CTL_ADD, conn->fd, &ev) == -1) {
+            conn->closed = true;
+            return -1;
+        } /* if */
+    } /* if */
+
+    if (epoll_wait(conn->epoll_fd, &ev, 1, timeout_ms) == -1
+     && errno != EINTR) {
+        conn->closed = true;
+        return -1;
+    } /* if */
+
+    net_flush(conn);
+
+    return net_read(conn);
+}
+/* EOF */
@@ -0,0 +1,184 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include "util.h"
+
+/* Port a game listens on unless told otherwise */
+#define NET_DEFAULT_PORT 7777
+
+/* Bumped whenever the wire format changes. Peers must agree on it */
+#define NET_PROTOCOL_VERSION 2
+
+/* Bytes of the longest message on the wire */
+#define NET_MAX_MSG 6
+
+/* Bytes each connection buffers in each direction */
+#define NET_BUFFER_SIZE 256
+
+typedef struct net_msg_t net_msg;
+typedef struct net_conn_t net_conn;
+
+/* Every message starts with its type byte and has a fixed length after it,
+ * so a message can be decoded as soon as its bytes have arrived:
+ *   MSG_HELLO   type, version, seat, bot     4 bytes
+ *   MSG_MOVE    type, turn, pos              3 bytes
+ *   MSG_SYNC    type, turn, X mask, O mask   6 bytes (masks little endian)
+ *   MSG_RESULT  type, result                 2 bytes */
+enum net_msg_types {
+    MSG_HELLO = 1,
+    MSG_MOVE = 2,
+    MSG_SYNC = 3,
+    MSG_RESULT = 4
+};
+
+/* A decoded message. Only the fields of its type are used:
+ * - HELLO opens a game. seat is the player the sender plays (1 or 2), or 0
+ *   to watch the server's bots play each other. bot asks a server for one of
+ *   its bots (the bot_difficulty plus one), or 0 for the server's choice
+ * - MOVE is a mark placed on square pos on the given turn (1 to 9)
+ * - SYNC answers a MOVE with the receiver's board after placing it, so that
+ *   the mover can check the boards agree and time the round trip
+ * - RESULT is the sender's result of the finished game (0 for a tie, or the
+ *   winning player) */
+struct net_msg_t
+{
+    uint8_t type;
+    uint8_t version;
+    uint8_t seat;
+    uint8_t bot;
+    uint8_t turn;
+    uint8_t pos;
+    uint8_t result;
+    board_t board;
+};
+
+/* A non-blocking socket with its partly read input and unsent output */
+struct net_conn_t
+{
+    int fd;
+    int epoll_fd;
+    bool closed;
+    size_t in_len;
+    size_t out_len;
+    uint8_t in[NET_BUFFER_SIZE];
+    uint8_t out[NET_BUFFER_SIZE];
+};
+
+/**
+ * Encodes a message into its wire format
+ * @param msg The message
+ * @param buf A buffer of at least NET_MAX_MSG bytes
+ * @return The number of bytes written, or -1 if the type is unknown
+ */
+int net_encode(const net_msg *msg, uint8_t *buf);
+
+/**
+ * Decodes the message at the start of a buffer
+ * @param buf The received bytes
+ * @param len The number of received bytes
+ * @param msg The decoded message. Passed in as an out value
+ * @return The number of bytes the message took, 0 if it has not fully
+ * arrived yet, or -1 if the bytes are not a valid message
+ */
+int net_decode(const uint8_t *buf, size_t len, net_msg *msg);
+
+/**
+ * Opens a non-blocking socket listening on every address
+ * @param port The TCP port
+ * @return The socket, or -1 if the port could not be bound
+ */
+int net_listen(int port);
+
+/**
+ * Accepts a pending connection without blocking
+ * @param listen_fd The listening socket
+ * @return The non-blocking socket of the connection, or -1 if none is pending
+ */
+int net_accept(int listen_fd);
+
+/**
+ * Starts connecting to a host without blocking. Wait for the socket to turn
+ * writable, then check net_socket_error to know whether it connected
+ * @param host The host name or address
+ * @param port The TCP port
+ * @return The connecting socket, or -1 if the host could not be resolved
+ */
+int net_connect(const char *host, int port);
+
+/**
+ * Gets the error left on a socket, such as the result of a connect
+ * @param fd The socket
+ * @return 0 if there is none, or the errno value
+ */
+int net_socket_error(int fd);
+
+/**
+ * Waits on epoll until a socket is ready or the timeout runs out
+ * @param fd The socket
+ * @param events The epoll events to wait for
+ * @param timeout_ms The longest time to wait, in milliseconds
+ * @return The ready events, 0 on a timeout, or -1 on an error
+ */
+int net_wait(int fd, uint32_t events, int timeout_ms);
+
+/**
+ * Wraps a connected non-blocking socket
+ * @param fd The socket. Closed by net_conn_destroy
+ * @return The connection, or NULL if there is no memory for it, in which
+ * case the socket is left open
+ */
+net_conn *net_conn_create(int fd);
+
+/**
+ * Closes the socket of a connection and frees it
+ * @param conn The connection
+ */
+void net_conn_destroy(net_conn *conn);
+
+/**
+ * Queues a message and sends as much of the queue as the socket takes
+ * @param conn The connection
+ * @param msg The message
+ * @return 0 on success, -1 if the connection is closed or its queue is full
+ */
+int net_send(net_conn *conn, const net_msg *msg);
+
+/**
+ * Sends as much of the queued output as the socket takes without blocking
+ * @param conn The connection
+ * @return 0 on success, -1 if the connection is closed
+ */
+int net_flush(net_conn *conn);
+
+/**
+ * Reads whatever input has arrived without blocking
+ * @param conn The connection
+ * @return 0 on success, -1 if the connection is closed
+ */
+int net_read(net_conn *conn);
+
+/**
+ * Takes the next complete message out of the input. A malformed message
+ * closes the connection
+ * @param conn The connection
+ * @param msg The message. Passed in as an out value
+ * @return Whether there was a complete message
+ */
+bool net_recv(net_conn *conn, net_msg *msg);
+
+/**
+ * Waits on epoll until input arrives or the timeout runs out, then reads it
+ * and sends any queued output
+ * @param conn The connection
+ * @param timeout_ms The longest time to wait, in milliseconds
+ * @return 0 on success, -1 if the connection is closed
+ */
+int net_poll(net_conn *conn, int timeout_ms);
+
+#endif
+/* EOF */
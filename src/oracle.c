@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "oracle.h"
+#include "util.h"
+
+/* Reads a position. Returns NULL, or what is wrong with it */
+static const char *
+parse_position(const char *text, const char *to_move, board_t *board,
+               int *player)
+{
+    int i, num_mine, num_theirs;
+
+    if (strlen(text) != 9) { return "a board is 9 squares"; }
+
+    board_clear(board);
+    for (i = 0; i < 9; i++) {
+        switch (text[i]) {
+            case 'X':
+            case 'x':
+                board_place(board, i, 1);
+                break;
+            case 'O':
+            case 'o':
+                board_place(board, i, 2);
+                break;
+            case ' ':
+            case '.':
+            case '-':
+            case '_':
+                break;
+            default:
+                return "squares are X, O or empty";
+        } /* switch */
+    } /* for */
+
+    /* X moves first, so by default the marks say whose turn it is */
+    if (to_move == NULL || to_move[0] == '\0') {
+        *player = __builtin_popcount(board->masks[0])
+                  == __builtin_popcount(board->masks[1]) ? 1 : 2;
+    } /* if */
+    else if (strcmp(to_move, "X") == 0 || strcmp(to_move, "x") == 0
+          || strcmp(to_move, "1") == 0) {
+        *player = 1;
+    } /* else if */
+    else if (strcmp(to_move, "O") == 0 || strcmp(to_move, "o") == 0
+          || strcmp(to_move, "2") == 0) {
+        *player = 2;
+    } /* else if */
+    else { return "the player to move is X or O"; }
+
+    num_mine = __builtin_popcount(board->masks[*player - 1]);
+    num_theirs = __builtin_popcount(board->masks[2 - *player]);
+    if (num_mine != num_theirs && num_mine + 1 != num_theirs) {
+        return "the player to move has too many or too few marks";
+    } /* if */
+    if (check_for_win(board) != -1) { return "the game is already over"; }
+
+    return NULL;
+}
+
+/* Gets the board and player the engines search for a position. The engines
+ * and their tables assume that X moves first, so when the player to move
+ * would break that, the marks swap sides, which changes no move or score */
+static void
+searched_position(const board_t *board, int player, board_t *searched,
+                  int *searched_player)
+{
+    int num_mine = __builtin_popcount(board->masks[player - 1]);
+    int num_theirs = __builtin_popcount(board->masks[2 - player]);
+
+    *searched_player = num_mine == num_theirs ? 1 : 2;
+    *searched = *board;
+    if (*searched_player != player) {
+        searched->masks[0] = board->masks[1];
+        searched->masks[1] = board->masks[0];
+    } /* if */
+}
+
+/* Prints the best moves and the evaluation of a 3x3 position */
+int
+oracle_answer(const char *text, const char *to_move, int bot, FILE *out)
+{
+    int i, player, num_moves, num_best, best_score, num_marks, plies;
+    int legal_moves[9], scores[9];
+    char squares[10];
+    const char *error;
+    board_t board, searched;
+
+    error = parse_position(text, to_move, &board, &player);
+    if (error != NULL) {
+        fprintf(out, "{\"error\": \"%s\"}\n", error);
+        return -1;
+    } /* if */
+
+    for (i = 0; i < 9; i++) { squares[i] = " XO"[board_get(&board, i)]; }
+    squares[9] = '\0';
+    fprintf(out, "{\"board\": \"%s\", \"to_move\": \"%c\", \"engine\": "
+            "\"%s\", \"best_moves\": [", squares, player == 1 ? 'X' : 'O',
+            bot_names[bot]);
+
+    searched_position(&board, player, &searched, &player);
+    num_moves = get_move_scores(&searched, player, bot, legal_moves, scores);
+
+    /* Bots that only pick a move have nothing more to say */
+    if (num_moves == -1) {
+        fprintf(out, "%d], \"eval\": null}\n",
+                bot_move_funcs[bot](&searched, player));
+        return 0;
+    } /* if */
+
+    best_score = -SCORE_INF;
+    for (i = 0; i < num_moves; i++) {
+        if (scores[i] > best_score) { best_score = scores[i]; }
+    } /* for */
+
+    num_best = 0;
+    for (i = 0; i < num_moves; i++) {
+        if (scores[i] != best_score) { continue; }
+        fprintf(out, num_best++ == 0 ? "%d" : ", %d", legal_moves[i]);
+    } /* for */
+
+    /* A score counts the marks of the final board, so it also says how many
+     * plies the game has left */
+    num_marks = __builtin_popcount(~board_empty(&board) & FULL_BOARD);
+    if (best_score == 0) { plies = 9 - num_marks; }
+    else { plies = WIN_SCORE + 9 - abs(best_score) - num_marks; }
+
+    fprintf(out, "], \"eval\": \"%s\", \"score\": %d, \"plies\": %d}\n",
+            best_score > 0 ? "win" : best_score < 0 ? "loss" : "draw",
+            best_score, plies);
+
+    return 0;
+}
+
+/* Answers one position per input line until the input ends */
+int
+oracle_stream(FILE *in, int bot, FILE *out)
+{
+    int num_errors = 0;
+    size_t len;
+    char line[ORACLE_MAX_LINE];
+    char to_move[ORACLE_MAX_LINE];
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        len = strcspn(line, "\r\n");
+
+        /* Drops the rest of a line too long to be a position */
+        if (line[len] == '\0' && !feof(in)) {
+            while (fgetc(in) != '\n' && !feof(in)) { }
+        } /* if */
+        line[len] = '\0';
+
+        /* The board keeps its spaces, so only what follows it is split. It
+         * is copied out before the board is cut off, since it may start
+         * right after the ninth square */
+        to_move[0] = '\0';
+        if (len > 9) {
+            strcpy(to_move, line + 9 + strspn(line + 9, " \t"));
+            line[9] = '\0';
+        } /* if */
+
+        if (oracle_answer(line, to_move, bot, out) != 0) { num_errors++; }
+        fflush(out);
+    } /* while */
+
+    return num_errors;
+}
+/* EOF */
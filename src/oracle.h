@@ -0,0 +1,36 @@
+#ifndef ORACLE_H
+#define ORACLE_H
+
+#include <stdio.h>
+
+/* Longest input line oracle_stream reads, newline included */
+#define ORACLE_MAX_LINE 256
+
+/**
+ * Prints the best moves and the evaluation of a 3x3 position as one line of
+ * JSON, without ncurses or any menus. A position that cannot be played on
+ * prints an error object instead
+ * @param text The board as 9 characters, square 0 (A1) first: X, O, or a
+ * space, '.', '-' or '_' for an empty square
+ * @param to_move The player to move (X, O, 1 or 2), or NULL to go by the
+ * number of marks on the board
+ * @param bot The bot_difficulty whose search answers
+ * @param out Where the answer is printed
+ * @return 0 on success, -1 if the position was not valid
+ */
+int oracle_answer(const char *text, const char *to_move, int bot, FILE *out);
+
+/**
+ * Answers one position per input line until the input ends, flushing each
+ * answer so that the oracle can run as a coprocess. A line is the 9
+ * characters of a board, optionally followed by spaces and the player to
+ * move
+ * @param in The positions
+ * @param bot The bot_difficulty whose search answers
+ * @param out Where the answers are printed, one per line
+ * @return The number of lines that were not valid positions
+ */
+int oracle_stream(FILE *in, int bot, FILE *out);
+
+#endif
+/* EOF */
@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include "order.h"
+
+unsigned int move_ordering = ORDER_ALL;
+
+static const char *heuristic_names[] = { "static", "tt", "killers", "history" };
+
+/* Starts the move ordering of a search with no killers or history */
+void
+order_init(move_order *order, const int *priority, int num_squares)
+{
+    order->heuristics = move_ordering;
+    memset(order->priority, 0, sizeof(order->priority));
+    memcpy(order->priority, priority, sizeof(int) * num_squares);
+    memset(order->killers, -1, sizeof(order->killers));
+    memset(order->history, 0, sizeof(order->history));
+}
+
+/* Sorts moves into the order they should be searched in */
+void
+order_moves(const move_order *order, int *moves, int num_moves, int tt_move,
+            int ply, int player)
+{
+    int i, j, move;
+    unsigned int key;
+    unsigned int keys[MNK_MAX_SQUARES];
+    unsigned int h = order->heuristics;
+
+    if (h == ORDER_NONE) { return; }
+
+    for (i = 0; i < num_moves; i++) {
+        move = moves[i];
+        key = 0;
+
+        if ((h & ORDER_TT) && move == tt_move) { key = 1U << 31; }
+        else if ((h & ORDER_KILLERS) && move == order->killers[ply][0]) {
+            key = 1U << 30;
+        } /* else if */
+        else if ((h & ORDER_KILLERS) && move == order->killers[ply][1]) {
+            key = 1U << 29;
+        } /* else if */
+        else {
+            if (h & ORDER_HISTORY) {
+                key = order->history[player - 1][move] * ORDER_PRIORITY_RANGE;
+            } /* if */
+            if (h & ORDER_STATIC) { key += order->priority[move]; }
+        } /* else */
+
+        /* Insertion sort, which keeps ties in order and is fastest on the
+         * short lists searches sort */
+        for (j = i; j > 0 && keys[j - 1] < key; j--) {
+            keys[j] = keys[j - 1];
+            moves[j] = moves[j - 1];
+        } /* for */
+        keys[j] = key;
+        moves[j] = move;
+    } /* for */
+}
+
+/* Records a move that caused a beta cutoff */
+void
+order_cutoff(move_order *order, int move, int ply, int player, int depth)
+{
+    unsigned int *history = &order->history[player - 1][move];
+
+    if (order->killers[ply][0] != move) {
+        order->killers[ply][1] = order->killers[ply][0];
+        order->killers[ply][0] = move;
+    } /* if */
+
+    *history += depth * depth;
+    if (*history > ORDER_HISTORY_MAX) { *history = ORDER_HISTORY_MAX; }
+}
+
+/* Parses a list of heuristics */
+int
+order_parse(const char *list, unsigned int *heuristics)
+{
+    int i;
+    size_t len;
+    const char *end;
+
+    if (strcmp(list, "none") == 0) {
+        *heuristics = ORDER_NONE;
+        return 0;
+    } /* if */
+    if (strcmp(list, "all") == 0) {
+        *heuristics = ORDER_ALL;
+        return 0;
+    } /* if */
+
+    *heuristics = ORDER_NONE;
+    while (*list != '\0') {
+        end = strchr(list, ',');
+        len = end != NULL ? (size_t)(end - list) : strlen(list);
+
+        for (i = 0; i < 4; i++) {
+            if (strlen(heuristic_names[i]) == len
+             && strncmp(list, heuristic_names[i], len) == 0) { break; }
+        } /* for */
+        if (i == 4) { return -1; }
+
+        *heuristics |= 1U << i;
+        list += len;
+        if (*list == ',') { list++; }
+    } /* while */
+
+    return 0;
+}
+/* EOF */
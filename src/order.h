@@ -0,0 +1,87 @@
+#ifndef ORDER_H
+#define ORDER_H
+
+#include "mnk.h"
+
+/* Plies a search can be below the empty board, plus the empty board itself */
+#define ORDER_MAX_PLY (MNK_MAX_SQUARES + 1)
+
+/* Static priorities stay below this, so that they only break history ties */
+#define ORDER_PRIORITY_RANGE 64
+
+/* History scores stop growing here, which keeps the sort keys in range */
+#define ORDER_HISTORY_MAX (1U << 20)
+
+/* The heuristics move_ordering can turn on */
+enum order_heuristics {
+    ORDER_NONE = 0,
+    ORDER_STATIC = 1,
+    ORDER_TT = 2,
+    ORDER_KILLERS = 4,
+    ORDER_HISTORY = 8,
+    ORDER_ALL = 15
+};
+
+typedef struct move_order_t move_order;
+
+/* The move ordering state of one search thread. Moves are tried in the order
+ * of: the transposition table's best move, the two killer moves of the ply
+ * (quiet moves that last caused a cutoff there), then by history score (how
+ * much cutting off with the move has saved so far), then by static priority */
+struct move_order_t
+{
+    unsigned int heuristics;
+    int priority[MNK_MAX_SQUARES];
+    int killers[ORDER_MAX_PLY][2];
+    unsigned int history[2][MNK_MAX_SQUARES];
+};
+
+/* The heuristics new searches use, as a set of order_heuristics */
+extern unsigned int move_ordering;
+
+/**
+ * Starts the move ordering of a search with no killers or history
+ * @param order The move ordering state
+ * @param priority The static priority of each square, below
+ * ORDER_PRIORITY_RANGE. Higher squares are tried first
+ * @param num_squares The number of squares
+ */
+void order_init(move_order *order, const int *priority, int num_squares);
+
+/**
+ * Sorts moves into the order they should be searched in. Moves that tie keep
+ * their order
+ * @param order The move ordering state
+ * @param moves The moves to sort
+ * @param num_moves The number of moves
+ * @param tt_move The best move the transposition table knows of, or -1
+ * @param ply The ply of the position below the empty board
+ * @param player The player to move
+ */
+void order_moves(const move_order *order, int *moves, int num_moves,
+                 int tt_move, int ply, int player);
+
+/**
+ * Records a move that caused a beta cutoff, as a killer of its ply and in the
+ * history of its player
+ * @param order The move ordering state
+ * @param move The move
+ * @param ply The ply of the position the move was made from
+ * @param player The player who made it
+ * @param depth The depth searched below the position. Deeper cutoffs save
+ * more and count for more
+ */
+void order_cutoff(move_order *order, int move, int ply, int player,
+                  int depth);
+
+/**
+ * Parses a comma separated list of heuristics (static, tt, killers, history)
+ * or one of none and all
+ * @param list The list
+ * @param heuristics The set of order_heuristics. Passed in as an out value
+ * @return 0 on success, -1 if the list names something else
+ */
+int order_parse(const char *list, unsigned int *heuristics);
+
+#endif
+/* EOF */
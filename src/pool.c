@@ -0,0 +1,164 @@
+#include <stdlib.h>
+
+#include "pool.h"
+
+int search_threads = 1;
+
+static _Thread_local bool is_worker = false;
+static pool_t *shared_pool = NULL;
+static pthread_once_t shared_pool_once = PTHREAD_ONCE_INIT;
+
+/* Runs jobs until the pool is stopped and its queue is empty */
+static void *
+worker_main(void *arg)
+{
+    pool_t *pool = arg;
+    pool_job job;
+
+    is_worker = true;
+    pthread_mutex_lock(&pool->lock);
+
+    while (true) {
+        while (pool->count == 0 && !pool->stopping) {
+            pthread_cond_wait(&pool->job_ready, &pool->lock);
+        } /* while */
+
+        if (pool->count == 0) { break; }
+
+        job = pool->jobs[pool->head];
+        pool->head = (pool->head + 1) % POOL_QUEUE_SIZE;
+        pool->count--;
+
+        /* Wakes a submitter waiting for room in the queue */
+        pthread_cond_broadcast(&pool->job_done);
+        pthread_mutex_unlock(&pool->lock);
+
+        job.func(job.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        job.group->pending--;
+        pthread_cond_broadcast(&pool->job_done);
+    } /* while */
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/* Creates a pool of worker threads */
+pool_t *
+pool_create(int num_threads)
+{
+    int i;
+    pool_t *pool = malloc(sizeof(pool_t));
+
+    if (pool == NULL) { return NULL; }
+    pool->threads = malloc(sizeof(pthread_t) * num_threads);
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    } /* if */
+
+    pool->num_threads = num_threads;
+    pool->head = 0;
+    pool->count = 0;
+    pool->stopping = false;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->job_ready, NULL);
+    pthread_cond_init(&pool->job_done, NULL);
+
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            /* Stops the workers that did start */
+            pool->num_threads = i;
+            pool_destroy(pool);
+            return NULL;
+        } /* if */
+    } /* for */
+
+    return pool;
+}
+
+/* Queues a job */
+void
+pool_submit(pool_t *pool, pool_group *group, pool_job_func func, void *arg)
+{
+    pool_job *job = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->count == POOL_QUEUE_SIZE) {
+        pthread_cond_wait(&pool->job_done, &pool->lock);
+    } /* while */
+
+    job = &pool->jobs[(pool->head + pool->count) % POOL_QUEUE_SIZE];
+    job->func = func;
+    job->arg = arg;
+    job->group = group;
+    pool->count++;
+    group->pending++;
+
+    pthread_cond_signal(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Waits until every job submitted in a group has finished */
+void
+pool_wait(pool_t *pool, pool_group *group)
+{
+    pthread_mutex_lock(&pool->lock);
+
+    while (group->pending > 0) {
+        pthread_cond_wait(&pool->job_done, &pool->lock);
+    } /* while */
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Finishes the queued jobs, then stops and frees the pool */
+void
+pool_destroy(pool_t *pool)
+{
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    } /* for */
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->job_ready);
+    pthread_cond_destroy(&pool->job_done);
+    free(pool->threads);
+    free(pool);
+}
+
+/* Checks whether the calling thread is a pool worker */
+bool
+pool_in_worker(void)
+{
+    return is_worker;
+}
+
+/* Creates the pool shared by the searches */
+static void
+create_shared_pool(void)
+{
+    shared_pool = pool_create(search_threads);
+}
+
+/* Gets the pool shared by the searches */
+pool_t *
+search_pool(void)
+{
+    if (search_threads <= 1 || is_worker) { return NULL; }
+
+    pthread_once(&shared_pool_once, create_shared_pool);
+
+    return shared_pool;
+}
+/* EOF */
@@ -0,0 +1,93 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/* Jobs that can wait in the queue before pool_submit blocks */
+#define POOL_QUEUE_SIZE 1024
+
+typedef struct pool_job_t pool_job;
+typedef struct pool_group_t pool_group;
+typedef struct pool_t pool_t;
+typedef void (*pool_job_func)(void *);
+
+/* A set of jobs that one caller waits on together */
+struct pool_group_t
+{
+    int pending;
+};
+
+struct pool_job_t
+{
+    pool_job_func func;
+    void *arg;
+    pool_group *group;
+};
+
+/* A fixed set of worker threads running jobs from a ring buffer queue */
+struct pool_t
+{
+    pthread_t *threads;
+    int num_threads;
+    pool_job jobs[POOL_QUEUE_SIZE];
+    int head;
+    int count;
+    bool stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;
+    pthread_cond_t job_done;
+};
+
+/* Threads the searches may use. 1 keeps every search on the calling thread */
+extern int search_threads;
+
+/**
+ * Creates a pool of worker threads
+ * @param num_threads The number of worker threads
+ * @return The pool, or NULL if there is no memory for it or a thread could
+ * not be started
+ */
+pool_t *pool_create(int num_threads);
+
+/**
+ * Queues a job, blocking while the queue is full
+ * @param pool The pool
+ * @param group The group to count the job in, for pool_wait
+ * @param func The function to run on a worker thread
+ * @param arg The argument passed to func
+ */
+void pool_submit(pool_t *pool, pool_group *group, pool_job_func func,
+                 void *arg);
+
+/**
+ * Waits until every job submitted in a group has finished
+ * @param pool The pool
+ * @param group The group to wait on
+ */
+void pool_wait(pool_t *pool, pool_group *group);
+
+/**
+ * Finishes the queued jobs, then stops and frees the pool
+ * @param pool The pool
+ */
+void pool_destroy(pool_t *pool);
+
+/**
+ * Checks whether the calling thread is a pool worker. Jobs must not wait on
+ * other jobs, since every worker could end up waiting
+ * @return Whether the calling thread is a pool worker
+ */
+bool pool_in_worker(void);
+
+/**
+ * Gets the pool shared by the searches, creating it with search_threads
+ * workers on first use
+ * @return The pool, or NULL if search_threads is 1, the caller is itself a
+ * worker or the pool could not be created, in which case the search should
+ * run on the calling thread
+ */
+pool_t *search_pool(void);
+
+#endif
+/* EOF */
@@ -0,0 +1,280 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "precache.h"
+
+static const char precache_magic[4] = { 'T', 'T', 'T', 'P' };
+
+/* The table used by lookups. Points into the mapped file, or into a table
+ * solved in memory when no file was loaded */
+static const uint16_t *precache_table = NULL;
+static void *precache_map = NULL;
+static size_t precache_map_len = 0;
+static uint16_t *precache_owned = NULL;
+static pthread_mutex_t precache_solve_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Gets the score of a solved board for the player to move, from its entry.
+ * The entry keeps the plies left until the end so that the score can tell a
+ * fast win from a slow one, like the bots' scores do */
+static int
+entry_score(uint16_t entry, const board_t *board, int player)
+{
+    int result = precache_result(entry);
+    int marks = __builtin_popcount(board->masks[0] | board->masks[1]);
+    int score = WIN_SCORE + 9 - marks - precache_plies(entry);
+
+    if (result == 0) { return 0; }
+
+    return result == player ? score : -score;
+}
+
+/* Solves a board and every board below it, filling in their entries. Returns
+ * the score of the board for the player to move */
+static int
+solve_board(uint16_t *table, const board_t *board, int player)
+{
+    int i, num_empty, status, score, marks, plies, result;
+    int opponent = player == 1 ? 2 : 1;
+    int best_score = -SCORE_INF;
+    int legal_moves[9];
+    uint16_t moves = 0;
+    uint32_t key = board_key(board);
+    board_t new_board;
+
+    if (table[key] != OUTCOME_UNREACHABLE) {
+        return entry_score(table[key], board, player);
+    } /* if */
+
+    status = check_for_win(board);
+
+    /* Only the player who just moved can have won */
+    if (status != -1) {
+        table[key] = (status + 1) << PRECACHE_OUTCOME_SHIFT;
+        return status == 0 ? 0 : -win_score(board);
+    } /* if */
+
+    num_empty = get_legal_moves(board, legal_moves);
+
+    /* The best moves win the fastest, or lose the slowest */
+    for (i = 0; i < num_empty; i++) {
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], player);
+        score = -solve_board(table, &new_board, opponent);
+
+        if (score > best_score) {
+            best_score = score;
+            moves = 0;
+        } /* if */
+        if (score == best_score) { moves |= 1 << legal_moves[i]; }
+    } /* for */
+
+    /* A tie always fills the board, and a win's score counts the marks of
+     * the board it ends on */
+    marks = 9 - num_empty;
+    if (best_score == 0) {
+        result = 0;
+        plies = num_empty;
+    } /* if */
+    else {
+        result = best_score > 0 ? player : opponent;
+        plies = WIN_SCORE + 9 - abs(best_score) - marks;
+    } /* else */
+
+    table[key] = moves | (result + 1) << PRECACHE_OUTCOME_SHIFT
+               | plies << PRECACHE_PLIES_SHIFT;
+
+    return best_score;
+}
+
+/* Solves every board reachable from the empty board */
+void
+precache_solve(uint16_t *table)
+{
+    board_t board;
+
+    board_clear(&board);
+    memset(table, 0, sizeof(uint16_t) * PRECACHE_ENTRIES);
+    solve_board(table, &board, 1);
+}
+
+/* Solves every reachable board and writes the table to a file */
+int
+precache_generate(const char *path)
+{
+    int status = 0;
+    FILE *file = NULL;
+    uint16_t *table = malloc(sizeof(uint16_t) * PRECACHE_ENTRIES);
+    precache_header header = { { 0 }, PRECACHE_VERSION, PRECACHE_ENTRIES, 0 };
+
+    if (table == NULL) { return -1; }
+
+    memcpy(header.magic, precache_magic, 4);
+    precache_solve(table);
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        free(table);
+        return -1;
+    } /* if */
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+     || fwrite(table, sizeof(uint16_t), PRECACHE_ENTRIES, file)
+        != PRECACHE_ENTRIES) {
+        status = -1;
+    } /* if */
+
+    if (fclose(file) != 0) { status = -1; }
+    free(table);
+
+    return status;
+}
+
+/* Checks that a mapped file holds a table this build can read */
+static bool
+precache_valid(const void *data, size_t len)
+{
+    const precache_header *header = data;
+
+    if (len != sizeof(precache_header)
+             + sizeof(uint16_t) * PRECACHE_ENTRIES) { return false; }
+
+    return memcmp(header->magic, precache_magic, 4) == 0
+        && header->version == PRECACHE_VERSION
+        && header->num_entries == PRECACHE_ENTRIES;
+}
+
+/* Maps a precache file into memory */
+int
+precache_load(const char *path)
+{
+#ifdef _WIN32
+    FILE *file = NULL;
+    size_t len = sizeof(precache_header) + sizeof(uint16_t) * PRECACHE_ENTRIES;
+    void *data = malloc(len + 1);
+
+    if (data == NULL) { return -1; }
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        free(data);
+        return -1;
+    } /* if */
+
+    len = fread(data, 1, len + 1, file);
+    fclose(file);
+#else
+    int fd;
+    struct stat st;
+    size_t len;
+    void *data = NULL;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) { return -1; }
+
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    } /* if */
+
+    len = st.st_size;
+    data = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) { return -1; }
+#endif
+
+    if (!precache_valid(data, len)) {
+#ifdef _WIN32
+        free(data);
+#else
+        munmap(data, len);
+#endif
+        return -1;
+    } /* if */
+
+    precache_unload();
+    precache_map = data;
+    precache_map_len = len;
+    precache_table = (const uint16_t *)((const char *)data
+                                        + sizeof(precache_header));
+
+    return 0;
+}
+
+/* Unmaps the precache file, or frees the table solved in its place */
+void
+precache_unload(void)
+{
+    if (precache_map != NULL) {
+#ifdef _WIN32
+        free(precache_map);
+#else
+        munmap(precache_map, precache_map_len);
+#endif
+    } /* if */
+
+    free(precache_owned);
+    precache_map = NULL;
+    precache_map_len = 0;
+    precache_owned = NULL;
+    precache_table = NULL;
+}
+
+/* Gets the table used by lookups */
+const uint16_t *
+precache_get_table(void)
+{
+    const uint16_t *table = __atomic_load_n(&precache_table, __ATOMIC_ACQUIRE);
+
+    /* Without a file, pays for one solve so that the bot still works. Only
+     * one thread solves; the others wait for its table. Without memory for
+     * it there is no table, and the next call tries again */
+    if (table == NULL) {
+        pthread_mutex_lock(&precache_solve_lock);
+        if (precache_table == NULL) {
+            precache_owned = malloc(sizeof(uint16_t) * PRECACHE_ENTRIES);
+            if (precache_owned != NULL) { precache_solve(precache_owned); }
+            __atomic_store_n(&precache_table, precache_owned,
+                             __ATOMIC_RELEASE);
+        } /* if */
+        table = precache_table;
+        pthread_mutex_unlock(&precache_solve_lock);
+    } /* if */
+
+    return table;
+}
+
+/* Looks up the entry for a board */
+uint16_t
+precache_lookup(const board_t *board)
+{
+    const uint16_t *table = precache_get_table();
+
+    return table != NULL ? table[board_key(board)] : OUTCOME_UNREACHABLE;
+}
+
+/* Converts the outcome of an entry into a game result */
+int
+precache_result(uint16_t entry)
+{
+    return (entry >> PRECACHE_OUTCOME_SHIFT & 3) - 1;
+}
+
+/* Gets the number of plies left until the game ends under perfect play */
+int
+precache_plies(uint16_t entry)
+{
+    return entry >> PRECACHE_PLIES_SHIFT & PRECACHE_PLIES_MASK;
+}
+/* EOF */
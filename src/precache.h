@@ -0,0 +1,113 @@
+#ifndef PRECACHE_H
+#define PRECACHE_H
+
+#include <stdint.h>
+
+#include "util.h"
+
+/* Default location of the precache file, relative to the repo root */
+#define PRECACHE_PATH "bin/precache.bin"
+
+/* Bumped whenever the layout of the precache file changes */
+#define PRECACHE_VERSION 2
+
+/* Number of entries in the table, one for every base-3 board key (3^9).
+ * Only 5478 of them are boards a game can reach. A dense table indexed by
+ * the rank of each reachable board would be 11 KB instead of 39 KB, but
+ * ranking a board takes a second table lookup or a search. Indexing by the
+ * key keeps a lookup to the key's multiply-adds and one load, lets
+ * batch_evaluate run as a branch-free loop, and turns the unreachable
+ * entries into a free validity check. The whole table still fits in L2 */
+#define PRECACHE_ENTRIES 19683
+
+/* Each entry is 16 bits. The low 9 bits are the set of best moves for the
+ * player to move, the next 2 bits are the outcome under perfect play and the
+ * next 4 bits are the plies left until the game ends. The best moves win the
+ * fastest or lose the slowest */
+#define PRECACHE_MOVES_MASK 0x1FF
+#define PRECACHE_OUTCOME_SHIFT 9
+#define PRECACHE_PLIES_SHIFT 11
+#define PRECACHE_PLIES_MASK 0xF
+
+enum precache_outcomes {
+    OUTCOME_UNREACHABLE = 0,
+    OUTCOME_TIE = 1,
+    OUTCOME_X_WINS = 2,
+    OUTCOME_O_WINS = 3
+};
+
+typedef struct precache_header_t precache_header;
+
+/* The file is this header followed by PRECACHE_ENTRIES entries in host byte
+ * order, indexed by board_key */
+struct precache_header_t
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t num_entries;
+    uint32_t reserved;
+};
+
+/**
+ * Solves every board reachable from the empty board
+ * @param table An array of PRECACHE_ENTRIES entries to fill in. Boards that
+ * cannot be reached are left as OUTCOME_UNREACHABLE
+ */
+void precache_solve(uint16_t *table);
+
+/**
+ * Solves every reachable board and writes the table to a file
+ * @param path The path of the file to write
+ * @return 0 on success, -1 if there is no memory to solve the table or the
+ * file could not be written
+ */
+int precache_generate(const char *path);
+
+/**
+ * Maps a precache file into memory for get_precache_bot_move
+ * @param path The path of the file to map
+ * @return 0 on success, -1 if the file is missing or invalid, or there is no
+ * memory to read it into
+ */
+int precache_load(const char *path);
+
+/**
+ * Unmaps the precache file, or frees the table solved in its place
+ */
+void precache_unload(void);
+
+/**
+ * Gets the whole table, indexed by board_key, for callers that look up many
+ * boards at once. If no file has been loaded, the table is solved in memory
+ * on first use instead
+ * @return The PRECACHE_ENTRIES entries of the table, or NULL if there is no
+ * memory to solve it in
+ */
+const uint16_t *precache_get_table(void);
+
+/**
+ * Looks up the entry for a board. If no file has been loaded, the table is
+ * solved in memory on first use instead
+ * @param board The tic-tac-toe board
+ * @return The packed entry of the board, or OUTCOME_UNREACHABLE if there is
+ * no table, which the precache bot answers with a random move
+ */
+uint16_t precache_lookup(const board_t *board);
+
+/**
+ * Converts the outcome of an entry into a game result
+ * @param entry The packed entry
+ * @return The result of the board. 0 if tie, 1/2 if player 1/2 wins, -1 if
+ * the board is unreachable
+ */
+int precache_result(uint16_t entry);
+
+/**
+ * Gets the number of plies left until the game ends under perfect play
+ * @param entry The packed entry
+ * @return The plies left, 0 if the board is already over
+ */
+int precache_plies(uint16_t entry);
+
+#endif
+/* EOF */
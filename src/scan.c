@@ -0,0 +1,177 @@
+#include "scan.h"
+
+/* SSE2 is part of every x86-64 CPU, while AVX2 is compiled for on its own
+ * and only run if the CPU reports it */
+#if defined(__x86_64__) && defined(__SSE2__)
+#include <immintrin.h>
+#define SCAN_X86
+#endif
+
+/* Checks the boards one at a time */
+static void
+scan_scalar(const board_t *boards, size_t count, int8_t *statuses,
+            uint16_t *legal_moves)
+{
+    size_t i;
+    int j, status;
+    uint16_t x, o;
+    bool x_wins, o_wins;
+
+    for (i = 0; i < count; i++) {
+        x = boards[i].masks[0];
+        o = boards[i].masks[1];
+        x_wins = false;
+        o_wins = false;
+
+        for (j = 0; j < 8; j++) {
+            x_wins |= (x & win_masks[j]) == win_masks[j];
+            o_wins |= (o & win_masks[j]) == win_masks[j];
+        } /* for */
+
+        if (x_wins) { status = 1; }
+        else if (o_wins) { status = 2; }
+        else if ((x | o) == FULL_BOARD) { status = 0; }
+        else { status = -1; }
+
+        statuses[i] = status;
+        legal_moves[i] = status == -1 ? ~(x | o) & FULL_BOARD : 0;
+    } /* for */
+}
+
+#ifdef SCAN_X86
+/* Checks 8 boards at once, one per 16-bit lane. Every compare gives all ones
+ * in the lanes where it holds, so the statuses are picked with masks instead
+ * of branches */
+static void
+scan_sse2(const board_t *boards, size_t count, int8_t *statuses,
+          uint16_t *legal_moves)
+{
+    size_t i;
+    int j;
+    __m128i lo, hi, x, o, line, x_wins, o_wins, full, status, live;
+    const __m128i full_board = _mm_set1_epi16(FULL_BOARD);
+    const __m128i none = _mm_set1_epi16(-1);
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        /* Each board is an X mask then an O mask, so the 32-bit lanes are
+         * split into their halves and packed into 16-bit lanes. The pack
+         * saturates to signed 16 bits, so the halves are sign extended first
+         * to come through whole even with bits above the board set */
+        lo = _mm_loadu_si128((const __m128i *)(boards + i));
+        hi = _mm_loadu_si128((const __m128i *)(boards + i + 4));
+        x = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                            _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+        o = _mm_packs_epi32(_mm_srai_epi32(lo, 16), _mm_srai_epi32(hi, 16));
+
+        x_wins = _mm_setzero_si128();
+        o_wins = _mm_setzero_si128();
+        for (j = 0; j < 8; j++) {
+            line = _mm_set1_epi16(win_masks[j]);
+            x_wins = _mm_or_si128(x_wins, _mm_cmpeq_epi16(
+                         _mm_and_si128(x, line), line));
+            o_wins = _mm_or_si128(o_wins, _mm_cmpeq_epi16(
+                         _mm_and_si128(o, line), line));
+        } /* for */
+
+        full = _mm_cmpeq_epi16(_mm_or_si128(x, o), full_board);
+        status = _mm_andnot_si128(full, none);
+        status = _mm_or_si128(_mm_and_si128(o_wins, _mm_set1_epi16(2)),
+                              _mm_andnot_si128(o_wins, status));
+        status = _mm_or_si128(_mm_and_si128(x_wins, _mm_set1_epi16(1)),
+                              _mm_andnot_si128(x_wins, status));
+        live = _mm_cmpeq_epi16(status, none);
+
+        _mm_storeu_si128((__m128i *)(legal_moves + i),
+                         _mm_and_si128(live, _mm_andnot_si128(
+                             _mm_or_si128(x, o), full_board)));
+        _mm_storel_epi64((__m128i *)(statuses + i),
+                         _mm_packs_epi16(status, status));
+    } /* for */
+
+    scan_scalar(boards + i, count - i, statuses + i, legal_moves + i);
+}
+
+/* Checks 16 boards at once, the same way as scan_sse2 */
+__attribute__((target("avx2")))
+static void
+scan_avx2(const board_t *boards, size_t count, int8_t *statuses,
+          uint16_t *legal_moves)
+{
+    size_t i;
+    int j;
+    __m256i lo, hi, x, o, line, x_wins, o_wins, full, status, live;
+    const __m256i low_half = _mm256_set1_epi32(0xFFFF);
+    const __m256i full_board = _mm256_set1_epi16(FULL_BOARD);
+    const __m256i none = _mm256_set1_epi16(-1);
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        /* Packing works within each 128-bit half, so the 64-bit quarters are
+         * put back in board order afterwards */
+        lo = _mm256_loadu_si256((const __m256i *)(boards + i));
+        hi = _mm256_loadu_si256((const __m256i *)(boards + i + 8));
+        x = _mm256_permute4x64_epi64(_mm256_packus_epi32(
+                _mm256_and_si256(lo, low_half),
+                _mm256_and_si256(hi, low_half)), 0xD8);
+        o = _mm256_permute4x64_epi64(_mm256_packus_epi32(
+                _mm256_srli_epi32(lo, 16), _mm256_srli_epi32(hi, 16)), 0xD8);
+
+        x_wins = _mm256_setzero_si256();
+        o_wins = _mm256_setzero_si256();
+        for (j = 0; j < 8; j++) {
+            line = _mm256_set1_epi16(win_masks[j]);
+            x_wins = _mm256_or_si256(x_wins, _mm256_cmpeq_epi16(
+                         _mm256_and_si256(x, line), line));
+            o_wins = _mm256_or_si256(o_wins, _mm256_cmpeq_epi16(
+                         _mm256_and_si256(o, line), line));
+        } /* for */
+
+        full = _mm256_cmpeq_epi16(_mm256_or_si256(x, o), full_board);
+        status = _mm256_andnot_si256(full, none);
+        status = _mm256_or_si256(_mm256_and_si256(o_wins,
+                                                  _mm256_set1_epi16(2)),
+                                 _mm256_andnot_si256(o_wins, status));
+        status = _mm256_or_si256(_mm256_and_si256(x_wins,
+                                                  _mm256_set1_epi16(1)),
+                                 _mm256_andnot_si256(x_wins, status));
+        live = _mm256_cmpeq_epi16(status, none);
+
+        _mm256_storeu_si256((__m256i *)(legal_moves + i),
+                            _mm256_and_si256(live, _mm256_andnot_si256(
+                                _mm256_or_si256(x, o), full_board)));
+        _mm_storeu_si128((__m128i *)(statuses + i),
+                         _mm_packs_epi16(_mm256_castsi256_si128(status),
+                                         _mm256_extracti128_si256(status, 1)));
+    } /* for */
+
+    scan_sse2(boards + i, count - i, statuses + i, legal_moves + i);
+}
+#endif
+
+/* Checks many boards for termination at once and gets their legal moves */
+void
+scan_boards(const board_t *boards, size_t count, int8_t *statuses,
+            uint16_t *legal_moves)
+{
+#ifdef SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        scan_avx2(boards, count, statuses, legal_moves);
+    } /* if */
+    else {
+        scan_sse2(boards, count, statuses, legal_moves);
+    } /* else */
+#else
+    scan_scalar(boards, count, statuses, legal_moves);
+#endif
+}
+
+/* Gets the name of the kernel scan_boards runs on this CPU */
+const char *
+scan_kernel(void)
+{
+#ifdef SCAN_X86
+    return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+/* EOF */
@@ -0,0 +1,33 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util.h"
+
+/**
+ * Checks many boards for termination at once and gets their legal moves.
+ * Runs 16 boards per step with AVX2 or 8 with SSE2 when the CPU has them,
+ * else one at a time. The statuses match check_for_win, except that a board
+ * where both players have a line (which no game can reach) counts as won by
+ * X
+ * @param boards The tic-tac-toe boards
+ * @param count The number of boards
+ * @param statuses The termination state of each board. -1 if the game should
+ * continue, 0 if the game is tied, 1/2 if player 1/2 won. Passed in as an out
+ * value
+ * @param legal_moves The set of empty squares of each board, bit i for square
+ * i, or 0 if the game is over. Passed in as an out value
+ */
+void scan_boards(const board_t *boards, size_t count, int8_t *statuses,
+                 uint16_t *legal_moves);
+
+/**
+ * Gets the name of the kernel scan_boards runs on this CPU
+ * @return "avx2", "sse2" or "scalar"
+ */
+const char *scan_kernel(void);
+
+#endif
+/* EOF */
@@ -0,0 +1,540 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "histogram.h"
+#include "net.h"
+#include "pool.h"
+#include "precache.h"
+#include "util.h"
+
+/* Events handled per epoll_wait */
+#define MAX_EVENTS 256
+
+/* Bot the server plays unless a client asks for another */
+#define DEFAULT_BOT BOT_PRECACHE
+
+typedef struct session_t session;
+
+enum session_states {
+    SESSION_GREETING,
+    SESSION_PLAYING,
+    SESSION_OVER
+};
+
+/* One client connection and the game it is playing. A connection can play
+ * any number of games one after another, each opened with a HELLO.
+ * client_seat is the player the client plays, or 0 if it watches the bots
+ * play each other. While a bot move is out on the pool, only the worker
+ * touches the game, and the event loop waits for it on the done list. A
+ * closed session waits on the dead list until the events already taken
+ * from epoll are handled, since some of them may still point to it */
+struct session_t
+{
+    net_conn *conn;
+    int state;
+    int client_seat;
+    game g;
+    bool bot_busy;
+    bool closing;
+    bool dead;
+    int bot_move;
+    long long turn_start_ns;
+    session *next_done;
+    session *next_dead;
+};
+
+/* The sessions whose bot moves have finished, handed from the workers to
+ * the event loop, which is woken through done_fd */
+static session *done_list = NULL;
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static int done_fd = -1;
+
+/* The sessions closed while handling the current batch of events */
+static session *dead_list = NULL;
+
+static volatile sig_atomic_t stopping = 0;
+
+static pool_t *pool = NULL;
+static pool_group bot_group = { 0 };
+static int default_bot = DEFAULT_BOT;
+
+/* Totals reported when the server stops */
+static long long games_started = 0;
+static long long games_finished = 0;
+static long long moves_played = 0;
+static long long sessions_opened = 0;
+static histogram latencies;
+
+/* Records how long a bot move took, from the start of its turn until the
+ * move was sent */
+static void
+record_latency(long long ns)
+{
+    hist_record(&latencies, ns);
+}
+
+/* Stops the event loop on SIGINT or SIGTERM */
+static void
+handle_signal(int sig)
+{
+    stopping = 1;
+}
+
+/* Runs a bot move on a pool worker, then hands the session back to the
+ * event loop */
+static void
+run_bot_move(void *arg)
+{
+    session *s = arg;
+    uint64_t one = 1;
+
+    s->bot_move = (*s->g.player_move_funcptr[s->g.cur_player - 1])(
+        &s->g.board, s->g.cur_player);
+
+    pthread_mutex_lock(&done_lock);
+    s->next_done = done_list;
+    done_list = s;
+    pthread_mutex_unlock(&done_lock);
+
+    if (write(done_fd, &one, sizeof(one)) == -1) { return; }
+}
+
+/* Stops watching a session's socket and puts the session on the dead list,
+ * unless a bot move of it is still out on the pool, in which case the move
+ * does */
+static void
+close_session(int epoll_fd, session *s)
+{
+    if (!s->closing) {
+        s->closing = true;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->conn->fd, NULL);
+    } /* if */
+    if (s->bot_busy || s->dead) { return; }
+
+    s->dead = true;
+    s->next_dead = dead_list;
+    dead_list = s;
+}
+
+/* Frees the sessions closed while handling the last batch of events */
+static void
+free_dead_sessions(void)
+{
+    session *s;
+
+    while (dead_list != NULL) {
+        s = dead_list;
+        dead_list = s->next_dead;
+        net_conn_destroy(s->conn);
+        free(s);
+    } /* while */
+}
+
+/* Sends what the session has queued and watches its socket for room if
+ * some of it did not fit */
+static void
+flush_session(int epoll_fd, session *s)
+{
+    struct epoll_event ev = { 0 };
+
+    if (net_flush(s->conn) == -1) {
+        close_session(epoll_fd, s);
+        return;
+    } /* if */
+
+    ev.events = EPOLLIN | EPOLLRDHUP | (s->conn->out_len > 0 ? EPOLLOUT : 0);
+    ev.data.ptr = s;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s->conn->fd, &ev);
+}
+
+/* Places a move in the session's game and switches players. Returns the
+ * result of the game, or -1 if it goes on */
+static int
+place_move(session *s, int pos)
+{
+    board_place(&s->g.board, pos, s->g.cur_player);
+    s->g.cur_player = s->g.cur_player == 1 ? 2 : 1;
+    s->g.turn++;
+    moves_played++;
+
+    return check_for_win(&s->g.board);
+}
+
+/* Sends the result of a finished game. The client may open another one.
+ * Returns false if the client's queue is full */
+static bool
+end_game(session *s, int result)
+{
+    net_msg msg = { 0 };
+
+    msg.type = MSG_RESULT;
+    msg.result = result;
+    s->state = SESSION_OVER;
+    games_finished++;
+
+    return net_send(s->conn, &msg) != -1;
+}
+
+/* Starts the bot's move if it is the bot's turn */
+static void
+start_turn(session *s)
+{
+    if (s->state != SESSION_PLAYING || s->g.cur_player == s->client_seat) {
+        return;
+    } /* if */
+
+    s->bot_busy = true;
+    s->turn_start_ns = now_ns();
+    pool_submit(pool, &bot_group, run_bot_move, s);
+}
+
+/* Sends a finished bot move to the client and moves on to the next turn.
+ * A client that has stopped reading is closed */
+static void
+finish_bot_move(int epoll_fd, session *s)
+{
+    int status;
+    net_msg msg = { 0 };
+
+    s->bot_busy = false;
+    msg.type = MSG_MOVE;
+    msg.turn = s->g.turn;
+    msg.pos = s->bot_move;
+    if (net_send(s->conn, &msg) == -1) {
+        close_session(epoll_fd, s);
+        return;
+    } /* if */
+    record_latency(now_ns() - s->turn_start_ns);
+
+    status = place_move(s, s->bot_move);
+    if (status == -1) { start_turn(s); }
+    else if (!end_game(s, status)) { close_session(epoll_fd, s); }
+}
+
+/* Opens a new game for a HELLO. The server answers with the player it
+ * plays, or 0 if it plays both. Returns false if the HELLO is for another
+ * version or the answer does not fit in the client's queue */
+static bool
+open_game(session *s, const net_msg *hello)
+{
+    int i;
+    net_msg msg = { 0 };
+
+    if (hello->version != NET_PROTOCOL_VERSION) { return false; }
+
+    s->client_seat = hello->seat;
+    s->g.cur_player = 1;
+    s->g.turn = 1;
+    s->g.show_stats = false;
+    board_clear(&s->g.board);
+    for (i = 0; i < 2; i++) {
+        s->g.players[i] = i + 1 == s->client_seat ? PLAYER_REMOTE
+                                                  : PLAYER_COMPUTER;
+        s->g.player_move_funcptr[i] = bot_move_funcs[
+            hello->bot > 0 ? hello->bot - 1 : default_bot];
+    } /* for */
+
+    msg.type = MSG_HELLO;
+    msg.version = NET_PROTOCOL_VERSION;
+    msg.seat = s->client_seat == 0 ? 0 : 3 - s->client_seat;
+    if (net_send(s->conn, &msg) == -1) { return false; }
+
+    s->state = SESSION_PLAYING;
+    games_started++;
+    start_turn(s);
+
+    return true;
+}
+
+/* Handles one message from a client. Returns false if the client broke the
+ * protocol, or stopped reading so that the answer does not fit in its
+ * queue */
+static bool
+handle_msg(session *s, const net_msg *msg)
+{
+    int status;
+    net_msg reply = { 0 };
+
+    switch (msg->type) {
+        case MSG_HELLO:
+            if (s->state == SESSION_PLAYING) { return false; }
+            return open_game(s, msg);
+        case MSG_MOVE:
+            if (s->state != SESSION_PLAYING
+             || s->g.cur_player != s->client_seat
+             || msg->turn != s->g.turn
+             || board_get(&s->g.board, msg->pos) != 0) {
+                return false;
+            } /* if */
+
+            /* The sync goes out before the result or the bot's move */
+            status = place_move(s, msg->pos);
+            reply.type = MSG_SYNC;
+            reply.turn = msg->turn;
+            reply.board = s->g.board;
+            if (net_send(s->conn, &reply) == -1) { return false; }
+            if (status == -1) { start_turn(s); }
+            else { return end_game(s, status); }
+            return true;
+        case MSG_SYNC:
+        case MSG_RESULT:
+            /* The server's board is the one that counts, so the client's
+             * echoes need no answer */
+            return true;
+        default:
+            return false;
+    } /* switch */
+}
+
+/* Reads whatever a client has sent, and handles it unless a bot move of
+ * the session is out on the pool. Reading it anyway keeps the socket from
+ * waking the event loop again until the move is back. A closed session may
+ * still have events in the batch, which are ignored */
+static void
+read_session(int epoll_fd, session *s)
+{
+    net_msg msg;
+
+    if (s->closing) { return; }
+
+    net_read(s->conn);
+    while (!s->bot_busy && net_recv(s->conn, &msg)) {
+        if (!handle_msg(s, &msg)) {
+            close_session(epoll_fd, s);
+            return;
+        } /* if */
+    } /* while */
+
+    if (s->conn->closed) {
+        close_session(epoll_fd, s);
+        return;
+    } /* if */
+
+    flush_session(epoll_fd, s);
+}
+
+/* Accepts every pending client */
+static void
+accept_sessions(int epoll_fd, int listen_fd)
+{
+    int fd;
+    session *s;
+    struct epoll_event ev = { 0 };
+
+    while ((fd = net_accept(listen_fd)) != -1) {
+        /* Without memory for it, the client is turned away */
+        s = calloc(1, sizeof(session));
+        if (s != NULL) { s->conn = net_conn_create(fd); }
+        if (s == NULL || s->conn == NULL) {
+            free(s);
+            close(fd);
+            continue;
+        } /* if */
+        s->state = SESSION_GREETING;
+        sessions_opened++;
+
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = s;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    } /* while */
+}
+
+/* Hands every finished bot move back to its session */
+static void
+drain_done(int epoll_fd)
+{
+    uint64_t count;
+    session *s, *next;
+
+    if (read(done_fd, &count, sizeof(count)) == -1) { return; }
+
+    pthread_mutex_lock(&done_lock);
+    s = done_list;
+    done_list = NULL;
+    pthread_mutex_unlock(&done_lock);
+
+    for (; s != NULL; s = next) {
+        next = s->next_done;
+        if (s->closing) {
+            s->bot_busy = false;
+            close_session(epoll_fd, s);
+            continue;
+        } /* if */
+
+        /* Then the messages that came in while the bot was thinking */
+        finish_bot_move(epoll_fd, s);
+        read_session(epoll_fd, s);
+    } /* for */
+}
+
+/* Raises the limit on open files as far as it goes, so that thousands of
+ * clients can connect */
+static void
+raise_file_limit(void)
+{
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    } /* if */
+}
+
+/* Prints the totals of the run as JSON */
+static void
+print_summary(double seconds, int num_workers)
+{
+    printf("{\n");
+    printf("  \"threads\": %d,\n", num_workers);
+    printf("  \"bot\": \"%s\",\n", bot_names[default_bot]);
+    printf("  \"seconds\": %.3f,\n", seconds);
+    printf("  \"sessions\": %lld,\n", sessions_opened);
+    printf("  \"games_started\": %lld,\n", games_started);
+    printf("  \"games_finished\": %lld,\n", games_finished);
+    printf("  \"moves\": %lld,\n", moves_played);
+    printf("  \"bot_moves\": %llu,\n", (unsigned long long)latencies.total);
+    printf("  \"bot_move_ns_p50\": %llu,\n",
+           (unsigned long long)hist_percentile(&latencies, 50));
+    printf("  \"bot_move_ns_p99\": %llu,\n",
+           (unsigned long long)hist_percentile(&latencies, 99));
+    printf("  \"bot_move_ns_p999\": %llu,\n",
+           (unsigned long long)hist_percentile(&latencies, 99.9));
+    printf("  \"bot_move_ns_max\": %llu\n",
+           (unsigned long long)latencies.max);
+    printf("}\n");
+}
+
+/* Prints the command-line options */
+static void
+usage(const char *prog)
+{
+    int i;
+
+    fprintf(stderr, "Usage: %s [--port N] [--threads N] [--bot NAME]\n",
+            prog);
+    fprintf(stderr, "  --port N     Port to listen on (default %d)\n",
+            NET_DEFAULT_PORT);
+    fprintf(stderr, "  --threads N  Threads the bot moves run on (default: "
+            "one per core)\n");
+    fprintf(stderr, "  --bot NAME   Bot played when a client does not ask "
+            "for one (default %s)\n", bot_names[DEFAULT_BOT]);
+    fprintf(stderr, "Bots:");
+    for (i = 0; i < NUM_BOTS; i++) { fprintf(stderr, " %s", bot_names[i]); }
+    fprintf(stderr, "\n");
+}
+
+/* Hosts games for any number of clients on one epoll event loop, with the
+ * bot moves run on a pool of workers. Prints its totals as JSON when it is
+ * stopped with SIGINT or SIGTERM */
+int
+main(int argc, char **argv)
+{
+    int i, n, ready, listen_fd, epoll_fd;
+    int port = NET_DEFAULT_PORT;
+    int num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    long long start;
+    struct sigaction sa;
+    struct epoll_event ev = { 0 }, events[MAX_EVENTS];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } /* if */
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_workers = atoi(argv[++i]);
+        } /* else if */
+        else if (strcmp(argv[i], "--bot") == 0 && i + 1 < argc) {
+            default_bot = find_bot(argv[++i]);
+            if (default_bot == -1) {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+        } /* else if */
+        else {
+            usage(argv[0]);
+            return 1;
+        } /* else */
+    } /* for */
+
+    if (num_workers < 1) { num_workers = 1; }
+
+    listen_fd = net_listen(port);
+    if (listen_fd == -1) {
+        fprintf(stderr, "Could not listen on port %d\n", port);
+        return 1;
+    } /* if */
+
+    /* Every game reads the one solved table, mapped from the file or solved
+     * here up front so that no client's move waits on it */
+    srand(time(NULL));
+    hist_init(&latencies);
+    precache_load(PRECACHE_PATH);
+    if (precache_get_table() == NULL) {
+        fprintf(stderr, "No memory for the precache table\n");
+        return 1;
+    } /* if */
+    init_caches();
+
+    raise_file_limit();
+    pool = pool_create(num_workers);
+    if (pool == NULL) {
+        fprintf(stderr, "Could not start %d workers\n", num_workers);
+        return 1;
+    } /* if */
+    done_fd = eventfd(0, EFD_NONBLOCK);
+    epoll_fd = epoll_create1(0);
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = &listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.ptr = &done_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, done_fd, &ev);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "Listening on port %d with %d threads\n", port,
+            num_workers);
+
+    start = now_ns();
+    while (!stopping) {
+        ready = epoll_wait(epoll_fd, events, MAX_EVENTS, 100);
+
+        for (n = 0; n < ready; n++) {
+            if (events[n].data.ptr == &listen_fd) {
+                accept_sessions(epoll_fd, listen_fd);
+            } /* if */
+            else if (events[n].data.ptr == &done_fd) {
+                drain_done(epoll_fd);
+            } /* else if */
+            else { read_session(epoll_fd, events[n].data.ptr); }
+        } /* for */
+
+        free_dead_sessions();
+    } /* while */
+
+    /* The sessions themselves go with the process */
+    pool_wait(pool, &bot_group);
+    print_summary((now_ns() - start) / 1e9, num_workers);
+
+    pool_destroy(pool);
+    close(epoll_fd);
+    close(done_fd);
+    close(listen_fd);
+    free_caches();
+    precache_unload();
+
+    return 0;
+}
+/* EOF */
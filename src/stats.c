@@ -0,0 +1,54 @@
+#include <string.h>
+
+#include "stats.h"
+
+_Thread_local search_stats stats;
+
+/* Clears the counters at the start of a bot move on a board of any size */
+void
+stats_reset(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/* Updates the maximum depth reached */
+void
+stats_ply(int ply)
+{
+    if (ply > stats.max_depth) { stats.max_depth = ply; }
+}
+
+/* Clears the counters at the start of a bot move */
+void
+stats_begin(const board_t *board)
+{
+    stats_reset();
+    stats.root_ply = __builtin_popcount(board->masks[0] | board->masks[1]);
+}
+
+/* Counts an expanded board and updates the maximum depth reached */
+void
+stats_node(const board_t *board)
+{
+    int depth = __builtin_popcount(board->masks[0] | board->masks[1])
+              - stats.root_ply;
+
+    stats.nodes++;
+    if (depth > stats.max_depth) { stats.max_depth = depth; }
+}
+
+/* Adds one set of counters into a running total */
+void
+stats_add(search_stats *total, const search_stats *add)
+{
+    total->nodes += add->nodes;
+    total->terminals += add->terminals;
+    total->probes += add->probes;
+    total->hits += add->hits;
+    total->stores += add->stores;
+    total->cutoffs += add->cutoffs;
+    if (add->max_depth > total->max_depth) {
+        total->max_depth = add->max_depth;
+    } /* if */
+}
+/* EOF */
@@ -0,0 +1,74 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "util.h"
+
+typedef struct search_stats_t search_stats;
+
+/* Counters for the work done by the last bot move. Only updated when built
+ * with -DTTT_STATS, so the searches pay nothing for them otherwise. Each
+ * thread counts into its own copy; pool workers hand theirs back to be
+ * merged with stats_add */
+struct search_stats_t
+{
+    unsigned long long nodes;
+    unsigned long long terminals;
+    unsigned long long probes;
+    unsigned long long hits;
+    unsigned long long stores;
+    unsigned long long cutoffs;
+    int max_depth;
+    int root_ply;
+};
+
+extern _Thread_local search_stats stats;
+
+#ifdef TTT_STATS
+    #define STATS_ENABLED 1
+    #define STATS_BEGIN(board) stats_begin(board)
+    #define STATS_RESET() stats_reset()
+    #define STAT_INC(field) (stats.field++)
+    #define STAT_NODE(board) stats_node(board)
+    #define STAT_PLY(ply) stats_ply(ply)
+#else
+    #define STATS_ENABLED 0
+    #define STATS_BEGIN(board) ((void)0)
+    #define STATS_RESET() ((void)0)
+    #define STAT_INC(field) ((void)0)
+    #define STAT_NODE(board) ((void)0)
+    #define STAT_PLY(ply) ((void)0)
+#endif
+
+/**
+ * Clears the counters at the start of a bot move on a board of any size
+ */
+void stats_reset(void);
+
+/**
+ * Updates the maximum depth reached
+ * @param ply The number of plies between the searched board and the root
+ */
+void stats_ply(int ply);
+
+/**
+ * Clears the counters at the start of a bot move
+ * @param board The board the bot is moving on, which is depth 0
+ */
+void stats_begin(const board_t *board);
+
+/**
+ * Counts an expanded board and updates the maximum depth reached
+ * @param board The board being expanded
+ */
+void stats_node(const board_t *board);
+
+/**
+ * Adds one set of counters into a running total. The maximum depth of the
+ * total is the deepest of the two
+ * @param total The running total
+ * @param add The counters to add
+ */
+void stats_add(search_stats *total, const search_stats *add);
+
+#endif
+/* EOF */
@@ -0,0 +1,22 @@
+#ifndef TTT_H
+#define TTT_H
+
+/* The engine in libttt (make lib): boards, bots, searches, caches, the
+ * precache solver, batch evaluation, the network protocol and latency
+ * histograms. None of it needs ncurses, which only the front end in tui.h
+ * uses */
+
+#include "batch.h"
+#include "hashtable.h"
+#include "histogram.h"
+#include "mnk.h"
+#include "net.h"
+#include "order.h"
+#include "pool.h"
+#include "precache.h"
+#include "scan.h"
+#include "stats.h"
+#include "util.h"
+
+#endif
+/* EOF */
@@ -0,0 +1,787 @@
+#include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include "tui.h"
+#include "net.h"
+#include "stats.h"
+
+typedef struct remote_peer_t remote_peer;
+
+/* The connection to the remote player and what both sides know of the game.
+ * board is the last board the two sides agreed on. A move of ours waits for
+ * the remote player's SYNC of it, which times its round trip */
+struct remote_peer_t
+{
+    net_conn *conn;
+    int seat;
+    board_t board;
+    board_t sent_board;
+    long long sent_ns;
+    long long rtt_ns[9];
+    int num_rtts;
+    int result;
+};
+
+static const char marks[3] = { ' ', 'X', 'O' };
+
+const char *remote_host = NULL;
+int remote_port = NET_DEFAULT_PORT;
+
+static remote_peer remote = { NULL, 0, { { 0, 0 } }, { { 0, 0 } }, 0, { 0 },
+                              0, -1 };
+
+/* Initializes ncurses */
+void
+init_ncurses(void)
+{
+    initscr();
+    noecho();
+    cbreak();
+    refresh();
+    curs_set(0);
+    keypad(stdscr, true);
+
+    printw("Welcome to Tic-Tac-Toe!");
+}
+
+/* Sets the player types */
+void
+set_players(int *players, bool allow_remote)
+{
+    int i, player, key;
+    int highlight = 1, widest_str_len = 15;
+    int num_opts = allow_remote ? 3 : 2;
+    bool should_continue = true;
+    WINDOW *player_select_win;
+    const char *player_options[] = {
+        "Local Player",
+        "Remote Player",
+        "Computer Player"
+    };
+    const int all_types[] = { PLAYER_LOCAL, PLAYER_REMOTE, PLAYER_COMPUTER };
+    const int local_types[] = { PLAYER_LOCAL, PLAYER_COMPUTER };
+    const int *option_types = allow_remote ? all_types : local_types;
+
+    player_select_win = newwin(num_opts + 2, widest_str_len + 2, 3, 0);
+    box(player_select_win, 0, 0);
+    wrefresh(player_select_win);
+    keypad(player_select_win, true);
+
+    for (player = 1; player < 3; player++) {
+        should_continue = true;
+        mvprintw(1, 0, "Choose player %d (%c):", player, marks[player]);
+        refresh();
+
+        /* Sets the player type for player 1 */
+        while (should_continue) {
+            for (i = 1; i <= num_opts; i++) {
+                if (i == highlight) { wattron(player_select_win, A_STANDOUT); }
+                mvwprintw(player_select_win, i, 1, "%s",
+                          player_options[option_types[i - 1]]);
+                wattroff(player_select_win, A_STANDOUT);
+            } /* for */
+            wrefresh(player_select_win);
+            key = wgetch(player_select_win);
+
+            switch (key) {
+                case KEY_UP:
+                case 'w':
+                    highlight--;
+                    if (highlight < 1) { highlight = num_opts; }
+                    break;
+                case KEY_DOWN:
+                case 's':
+                    highlight++;
+                    if (highlight > num_opts) { highlight = 1; }
+                    break;
+                case 10:
+                    players[player - 1] = option_types[highlight - 1];
+                    should_continue = false;
+                    break;
+                default:
+                    break;
+            } /* switch */
+        } /* while */
+    } /* for */
+
+    delwin(player_select_win);
+    player_select_win = NULL;
+    clear();
+    refresh();
+}
+
+/* Sets the player move function pointers */
+void 
+set_player_moves(int *players, player_move_func *player_move_funcptr)
+{
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        switch (players[i]) {
+            case PLAYER_LOCAL:
+                player_move_funcptr[i] = get_local_move;
+                break;
+            case PLAYER_REMOTE:
+                player_move_funcptr[i] = get_remote_move;
+                break;
+            case PLAYER_COMPUTER:
+                player_move_funcptr[i] = set_bot_difficulty(i + 1);
+                break;
+            default:
+                break;
+        } /* switch */
+    } /* for */
+
+    /* Connects once both sides are done with their menus, so that neither
+     * side's first move waits on the other's menus */
+    for (i = 0; i < 2; i++) {
+        if (players[i] == PLAYER_REMOTE) { establish_connection(i + 1); }
+    } /* for */
+}
+
+/* Gets a move from a local player */
+int
+get_local_move(const board_t *board, int cur_player)
+{
+    int i, pos, key;
+    int pos_hi = 0;
+    bool should_continue = true;
+
+    while (should_continue) {
+        for (i = 0; i < 9; i++) {
+            if (i == pos_hi) { attron(A_STANDOUT); }
+            mvprintw(3 + 3 * (i / 3), 3 + 4 * (i % 3), "%c",
+                     marks[board_get(board, i)]);
+            attroff(A_STANDOUT);
+        } /* for */
+        refresh();
+        key = getch();
+
+        switch (key) {
+            case KEY_UP:
+            case 'w':
+                pos_hi -= 3;
+                if (pos_hi < 0) { pos_hi += 9; }
+                break;
+            case KEY_DOWN:
+            case 's':
+                pos_hi += 3;
+                if (pos_hi > 8) { pos_hi -= 9; }
+                break;
+            case KEY_LEFT:
+            case 'a':
+                pos_hi--;
+                if (pos_hi == -1 || pos_hi == 2 || pos_hi == 5) { pos_hi += 3; }
+                break;
+            case KEY_RIGHT:
+            case 'd':
+                pos_hi++;
+                if (pos_hi == 3 || pos_hi == 6 || pos_hi == 9) { pos_hi -= 3; }
+                break;
+            case 10:
+                if (board_get(board, pos_hi) == 0) {
+                    pos = pos_hi;
+                    should_continue = false;
+                }
+                break;
+            default:
+                break;
+        } /* switch */
+    } /* while */
+
+    return pos;
+}
+
+/* Leaves the game because of a problem with the remote player */
+static void
+remote_fail(const char *reason)
+{
+    endwin();
+    fprintf(stderr, "%s\n", reason);
+    exit(1);
+}
+
+/* Shows what the game is waiting on, with a spinner so that the wait is
+ * visibly alive. Pressing q gives up on the remote player */
+static void
+remote_status(const char *waiting_on, long long start_ns)
+{
+    static const char spinner[4] = { '|', '/', '-', '\\' };
+    long long waited_ns = now_ns() - start_ns;
+    int key;
+
+    move(REMOTE_ROW, 0);
+    clrtoeol();
+    if (waiting_on != NULL) {
+        mvprintw(REMOTE_ROW, 0, "%s %c (%.1fs, q to quit)", waiting_on,
+                 spinner[waited_ns / 125000000 % 4], waited_ns / 1e9);
+    } /* if */
+    refresh();
+
+    nodelay(stdscr, true);
+    key = getch();
+    nodelay(stdscr, false);
+    if (key == 'q') { remote_fail("Left the game with the remote player"); }
+}
+
+/* Shows the round trip times of the moves sent so far */
+static void
+print_round_trips(void)
+{
+    int i;
+
+    move(REMOTE_ROW + 1, 0);
+    clrtoeol();
+    if (remote.num_rtts == 0) { return; }
+
+    mvprintw(REMOTE_ROW + 1, 0, "Round trips (ms):");
+    for (i = 0; i < remote.num_rtts; i++) {
+        printw(" %.3f", remote.rtt_ns[i] / 1e6);
+    } /* for */
+}
+
+/* Sends the mark placed on the board since the two sides last agreed on it,
+ * if there is one */
+static void
+send_local_move(const board_t *board)
+{
+    uint16_t placed = ~board_empty(board) & board_empty(&remote.board)
+                      & FULL_BOARD;
+    net_msg msg = { 0 };
+
+    if (placed == 0) { return; }
+
+    msg.type = MSG_MOVE;
+    msg.turn = __builtin_popcount(~board_empty(board) & FULL_BOARD);
+    msg.pos = __builtin_ctz(placed);
+    remote.sent_board = *board;
+    remote.sent_ns = now_ns();
+    remote.board = *board;
+
+    if (net_send(remote.conn, &msg) == -1) {
+        remote_fail("Lost the connection to the remote player");
+    } /* if */
+}
+
+/* Handles a message from the remote player. Returns the square of their move
+ * if it was one, or -1 */
+static int
+handle_remote_msg(const net_msg *msg)
+{
+    int turn = __builtin_popcount(~board_empty(&remote.board) & FULL_BOARD);
+    net_msg reply = { 0 };
+
+    switch (msg->type) {
+        case MSG_SYNC:
+            if (remote.sent_ns == 0 || msg->turn != turn
+             || memcmp(&msg->board, &remote.sent_board, sizeof(board_t))) {
+                remote_fail("The remote player's board is out of sync");
+            } /* if */
+            remote.rtt_ns[remote.num_rtts++] = now_ns() - remote.sent_ns;
+            remote.sent_ns = 0;
+            print_round_trips();
+            return -1;
+        case MSG_MOVE:
+            if (msg->turn != turn + 1
+             || (board_empty(&remote.board) & 1 << msg->pos) == 0) {
+                remote_fail("The remote player made an illegal move");
+            } /* if */
+            board_place(&remote.board, msg->pos, remote.seat);
+
+            /* Echoes the board back so that the mover can check it */
+            reply.type = MSG_SYNC;
+            reply.turn = msg->turn;
+            reply.board = remote.board;
+            net_send(remote.conn, &reply);
+            return msg->pos;
+        case MSG_RESULT:
+            remote.result = msg->result;
+            return -1;
+        default:
+            remote_fail("The remote player sent an unexpected message");
+            return -1;
+    } /* switch */
+}
+
+/* Gets a move from a remote player */
+int
+get_remote_move(const board_t *board, int cur_player)
+{
+    int pos = -1;
+    long long start = now_ns();
+    net_msg msg;
+
+    send_local_move(board);
+
+    while (true) {
+        while (pos == -1 && net_recv(remote.conn, &msg)) {
+            pos = handle_remote_msg(&msg);
+        } /* while */
+        if (pos != -1) { break; }
+        if (remote.conn->closed) {
+            remote_fail("The remote player left the game");
+        } /* if */
+
+        remote_status("Waiting for the remote player", start);
+        net_poll(remote.conn, 50);
+    } /* while */
+
+    remote_status(NULL, start);
+
+    return pos;
+}
+
+/* Opens a connection to the remote player, listening for them or connecting
+ * to them. Connecting retries until the remote player is listening */
+static int
+open_connection(void)
+{
+    int fd = -1, listen_fd, events;
+    long long start = now_ns();
+    char waiting_on[80];
+
+    if (remote_host == NULL) {
+        listen_fd = net_listen(remote_port);
+        if (listen_fd == -1) { remote_fail("Could not listen on that port"); }
+        snprintf(waiting_on, sizeof(waiting_on),
+                 "Waiting for a player on port %d", remote_port);
+
+        while ((fd = net_accept(listen_fd)) == -1) {
+            remote_status(waiting_on, start);
+            net_wait(listen_fd, EPOLLIN, 50);
+        } /* while */
+
+        close(listen_fd);
+        return fd;
+    } /* if */
+
+    snprintf(waiting_on, sizeof(waiting_on), "Connecting to %s:%d",
+             remote_host, remote_port);
+    while (fd == -1) {
+        fd = net_connect(remote_host, remote_port);
+        if (fd == -1) { remote_fail("Could not find the remote host"); }
+
+        do {
+            remote_status(waiting_on, start);
+            events = net_wait(fd, EPOLLOUT, 50);
+        } while (events == 0);
+
+        if (events == -1 || net_socket_error(fd) != 0) {
+            close(fd);
+            fd = -1;
+            napms(200);
+        } /* if */
+    } /* while */
+
+    return fd;
+}
+
+/* Establishes a connection to a remote player */
+void 
+establish_connection(int remote_player)
+{
+    int fd;
+    long long start;
+    net_msg msg = { 0 };
+
+    if (remote.conn != NULL) {
+        remote_fail("Only one of the players can be a remote player");
+    } /* if */
+
+    fd = open_connection();
+    remote.conn = net_conn_create(fd);
+    if (remote.conn == NULL) {
+        close(fd);
+        remote_fail("Out of memory for the connection");
+    } /* if */
+    remote.seat = remote_player;
+    remote.result = -1;
+    remote.num_rtts = 0;
+    remote.sent_ns = 0;
+    board_clear(&remote.board);
+
+    /* Each side says which player it plays, and they must not clash */
+    msg.type = MSG_HELLO;
+    msg.version = NET_PROTOCOL_VERSION;
+    msg.seat = remote_player == 1 ? 2 : 1;
+    net_send(remote.conn, &msg);
+
+    start = now_ns();
+    while (!net_recv(remote.conn, &msg)) {
+        if (remote.conn->closed) {
+            remote_fail("The remote player left the game");
+        } /* if */
+        remote_status("Greeting the remote player", start);
+        net_poll(remote.conn, 50);
+    } /* while */
+
+    if (msg.type != MSG_HELLO || msg.version != NET_PROTOCOL_VERSION) {
+        remote_fail("The remote player's game is a different version");
+    } /* if */
+    if (msg.seat != remote_player) {
+        remote_fail("Both sides chose the same player");
+    } /* if */
+
+    remote_status(NULL, start);
+}
+
+/* Sends the last move and the result of a finished game to the remote
+ * player */
+void
+close_connection(const board_t *board, int result)
+{
+    long long start = now_ns(), total_ns = 0;
+    int i;
+    net_msg msg = { 0 };
+
+    if (remote.conn == NULL) { return; }
+
+    send_local_move(board);
+    msg.type = MSG_RESULT;
+    msg.result = result;
+    net_send(remote.conn, &msg);
+
+    /* The remote player may leave as soon as they have our result, so a
+     * closed connection only ends the wait */
+    while (net_recv(remote.conn, &msg)) { handle_remote_msg(&msg); }
+    while ((remote.result == -1 || remote.sent_ns != 0)
+        && !remote.conn->closed
+        && now_ns() - start < REMOTE_CLOSE_MS * 1000000LL) {
+        remote_status("Waiting for the remote player's result", start);
+        net_poll(remote.conn, 50);
+        while (net_recv(remote.conn, &msg)) { handle_remote_msg(&msg); }
+    } /* while */
+
+    move(REMOTE_ROW, 0);
+    clrtoeol();
+    if (remote.result != -1 && remote.result != result) {
+        mvprintw(REMOTE_ROW, 0, "The remote player saw a different result!");
+    } /* if */
+    else if (remote.num_rtts > 0) {
+        for (i = 0; i < remote.num_rtts; i++) { total_ns += remote.rtt_ns[i]; }
+        mvprintw(REMOTE_ROW, 0, "Average round trip: %.3f ms over %d moves",
+                 total_ns / 1e6 / remote.num_rtts, remote.num_rtts);
+    } /* else if */
+    print_round_trips();
+    refresh();
+
+    net_conn_destroy(remote.conn);
+    remote.conn = NULL;
+}
+
+/* Sets the difficulty level of a computer opponent */
+player_move_func
+set_bot_difficulty(int player)
+{
+    int i, key;
+    int diff_hi = 0, num_opts = NUM_BOTS, widest_str_len = 38;
+    bool should_continue = true;
+    player_move_func diff_mode;
+    WINDOW *diff_win;
+    const char *difficulty_options[] = {
+        "Easy - (Moves randomly)",
+        "Med  - (Easy but makes winning moves)",
+        "Hard - (Minimax)",
+        "Hard - (Minimax w/ cache)",
+        "Hard - (Minimax w/ fast cache)",
+        "Hard - (Minimax w/ alpha beta pruning)",
+        "Hard - (Precache)",
+        "Hard - (Lazy SMP w/ shared table)"
+    };
+
+    diff_win = newwin(num_opts + 2, widest_str_len + 2, 2, 0);
+    box(diff_win, 0, 0);
+    wrefresh(diff_win);
+    keypad(diff_win, true);
+
+    mvprintw(0, 0, "Choose player %d bot difficulty:", player);
+    refresh();
+
+    while (should_continue) {
+        for (i = 0; i < num_opts; i++) {
+            if (i == diff_hi) { wattron(diff_win, A_STANDOUT); }
+            mvwprintw(diff_win, i + 1, 1, "%s", difficulty_options[i]);
+            wattroff(diff_win, A_STANDOUT);
+        } /* for */
+        wrefresh(diff_win);
+        key = wgetch(diff_win);
+
+        switch (key) {
+            case KEY_UP:
+            case 'w':
+                diff_hi--;
+                if (diff_hi < 0) { diff_hi = num_opts - 1; }
+                break;
+            case KEY_DOWN:
+            case 's':
+                diff_hi++;
+                if (diff_hi >= num_opts) { diff_hi = 0; }
+                break;
+            case 10:
+                diff_mode = bot_move_funcs[diff_hi];
+                should_continue = false;
+                break;
+            default:
+                break;
+        } /* switch */
+    } /* while */
+
+    delwin(diff_win);
+    diff_win = NULL;
+    clear();
+    refresh();
+
+    return diff_mode;
+}
+
+/* Performs the main game loop of drawing the board, getting a move, placing a
+ * mark, then switching players */
+int 
+game_loop(game *g)
+{
+    int mover;
+    int status = -1;
+
+    while (status == -1) {
+        mvprintw(0, 0, "Player %d's turn (%c) (turn %d):", g->cur_player,
+                 marks[g->cur_player], g->turn);
+        refresh();
+        print_board(&g->board);
+
+        mover = g->cur_player;
+        STATS_BEGIN(&g->board);
+        status = play_turn(g);
+
+        if (g->show_stats && g->players[mover - 1] == PLAYER_COMPUTER) {
+            print_stats(mover, STATS_ROW);
+        } /* if */
+
+        /* Sleep for a second after bot moves so that the user can see moves
+         * being made. Otherwise, the game just appears finished instantly and
+         * is boring */
+        if (g->players[0] == PLAYER_COMPUTER
+         && g->players[1] == PLAYER_COMPUTER) {
+#ifdef _WIN32
+            Sleep(1000);
+#else
+            sleep(1);
+#endif
+        } /* if */
+    } /* while */
+
+    print_board(&g->board);
+
+    return status;
+}
+
+/* Prints the current state of the board */
+void 
+print_board(const board_t *board)
+{
+    int i;
+    char m[9];
+
+    for (i = 0; i < 9; i++) {
+        m[i] = marks[board_get(board, i)];
+    } /* for */
+
+    mvprintw( 2, 0, "     |   |   ");
+    mvprintw( 3, 0, "A  %c | %c | %c ", m[0], m[1], m[2]);
+    mvprintw( 4, 0, "  ___|___|___");
+    mvprintw( 5, 0, "     |   |   ");
+    mvprintw( 6, 0, "B  %c | %c | %c ", m[3], m[4], m[5]);
+    mvprintw( 7, 0, "  ___|___|___");
+    mvprintw( 8, 0, "     |   |   ");
+    mvprintw( 9, 0, "C  %c | %c | %c ", m[6], m[7], m[8]);
+    mvprintw(10, 0, "     |   |   ");
+    mvprintw(12, 0, "   1 | 2 | 3 ");
+    refresh();
+}
+
+/* Prints the current state of an m,n,k board */
+void
+print_mnk_board(const mnk_board *board, int cursor)
+{
+    int x, y, pos;
+
+    move(2, 0);
+    clrtoeol();
+    for (x = 0; x < board->width; x++) {
+        mvprintw(2, 3 + 3 * x, "%2d", x + 1);
+    } /* for */
+
+    for (y = 0; y < board->height; y++) {
+        mvprintw(3 + y, 0, "%c", 'A' + y);
+        for (x = 0; x < board->width; x++) {
+            pos = y * board->width + x;
+            if (pos == cursor) { attron(A_STANDOUT); }
+            mvprintw(3 + y, 3 + 3 * x, " %c",
+                     mnk_get(board, pos) ? marks[mnk_get(board, pos)] : '.');
+            attroff(A_STANDOUT);
+        } /* for */
+    } /* for */
+
+    refresh();
+}
+
+/* Gets a move from a local player on an m,n,k board */
+int
+get_mnk_local_move(mnk_board *board, int cur_player)
+{
+    int key, pos;
+    int pos_hi = board->height / 2 * board->width + board->width / 2;
+    int width = board->width, num_squares = board->num_squares;
+    bool should_continue = true;
+
+    while (should_continue) {
+        print_mnk_board(board, pos_hi);
+        key = getch();
+
+        switch (key) {
+            case KEY_UP:
+            case 'w':
+                pos_hi -= width;
+                if (pos_hi < 0) { pos_hi += num_squares; }
+                break;
+            case KEY_DOWN:
+            case 's':
+                pos_hi += width;
+                if (pos_hi >= num_squares) { pos_hi -= num_squares; }
+                break;
+            case KEY_LEFT:
+            case 'a':
+                if (pos_hi % width == 0) { pos_hi += width; }
+                pos_hi--;
+                break;
+            case KEY_RIGHT:
+            case 'd':
+                pos_hi++;
+                if (pos_hi % width == 0) { pos_hi -= width; }
+                break;
+            case 10:
+                if (mnk_get(board, pos_hi) == 0) {
+                    pos = pos_hi;
+                    should_continue = false;
+                }
+                break;
+            default:
+                break;
+        } /* switch */
+    } /* while */
+
+    return pos;
+}
+
+/* Performs the main game loop on an m,n,k board */
+int
+mnk_game_loop(game *g, mnk_board *board)
+{
+    int i, pos;
+    int status = -1;
+    mnk_move_func move_funcs[2];
+
+    for (i = 0; i < 2; i++) {
+        move_funcs[i] = g->players[i] == PLAYER_COMPUTER ? get_mnk_bot_move
+                                                         : get_mnk_local_move;
+    } /* for */
+
+    while (status == -1) {
+        mvprintw(0, 0, "Player %d's turn (%c) (turn %d), %d in a row wins:",
+                 g->cur_player, marks[g->cur_player], g->turn, board->k);
+        print_mnk_board(board, -1);
+
+        STATS_RESET();
+        pos = (*move_funcs[g->cur_player - 1])(board, g->cur_player);
+        mnk_place(board, pos, g->cur_player);
+
+        if (g->show_stats
+         && g->players[g->cur_player - 1] == PLAYER_COMPUTER) {
+            print_stats(g->cur_player, mnk_footer_row(board));
+        } /* if */
+
+        /* Same delay as game_loop so that bot games can be followed */
+        if (g->players[0] == PLAYER_COMPUTER
+         && g->players[1] == PLAYER_COMPUTER) {
+#ifdef _WIN32
+            Sleep(1000);
+#else
+            sleep(1);
+#endif
+        } /* if */
+
+        status = mnk_check_for_win(board, pos);
+        g->cur_player = g->cur_player == 1 ? 2 : 1;
+        g->turn++;
+    } /* while */
+
+    print_mnk_board(board, -1);
+
+    return status;
+}
+
+/* Gets the screen row of the stats below an m,n,k board */
+int
+mnk_footer_row(const mnk_board *board)
+{
+    return board->height + 5;
+}
+
+/* Prints the search counters of the last bot move */
+void
+print_stats(int player, int row)
+{
+    if (!STATS_ENABLED) {
+        mvprintw(row, 0, "Search stats need a build with -DTTT_STATS "
+                 "(make stats)");
+        refresh();
+        return;
+    } /* if */
+
+    move(row, 0);
+    clrtoeol();
+    mvprintw(row, 0, "Player %d search: %llu nodes, %llu terminal, "
+             "max depth %d", player, stats.nodes, stats.terminals,
+             stats.max_depth);
+    move(row + 1, 0);
+    clrtoeol();
+    mvprintw(row + 1, 0, "  cache: %llu probes, %llu hits, %llu stores; "
+             "%llu cutoffs", stats.probes, stats.hits, stats.stores,
+             stats.cutoffs);
+    refresh();
+}
+
+/* Prints the results of the game */
+void
+print_results(int result, int row)
+{
+    switch (result) {
+        case 0:
+            mvprintw(row, 0, "The game is a tie!");
+            break;
+        case 1:
+            mvprintw(row, 0, "Player 1 (X) wins!");
+            break;
+        case 2:
+            mvprintw(row, 0, "Player 2 (O) wins");
+            break;
+        default:
+            mvprintw(row, 0, "How did you play a game that neither won nor "
+                    "tied?");
+            break;
+    } /* switch */
+
+    mvprintw(row + 1, 0, "Thanks for playing! Press any key to exit.");
+    refresh();
+    getch();
+
+    endwin();
+}
+/* EOF */
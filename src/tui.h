@@ -0,0 +1,147 @@
+#ifndef TUI_H
+#define TUI_H
+
+#include <stdbool.h>
+
+#include "mnk.h"
+#include "util.h"
+
+/* Screen rows of the search stats and the results below the 3x3 board */
+#define RESULTS_ROW 15
+#define STATS_ROW 18
+
+/* Screen row of the remote player's status and round trip times */
+#define REMOTE_ROW 13
+
+/* Time close_connection waits for the remote player's result */
+#define REMOTE_CLOSE_MS 5000
+
+/* Where establish_connection finds the remote player. With no host it
+ * listens on the port for the remote player to connect instead */
+extern const char *remote_host;
+extern int remote_port;
+
+/**
+ * Initializes ncurses
+ */
+void init_ncurses(void);
+
+/**
+ * Sets the player types
+ * @param players An array containing the chosen player types
+ * @param allow_remote Whether remote players are offered
+ */
+void set_players(int *players, bool allow_remote);
+
+/**
+ * Sets the player move function pointers
+ * @param players An array containing the chosen player types
+ * @param player_move_funcptr An array containing the player move functions
+ */
+void set_player_moves(int *players, player_move_func *player_move_funcptr);
+
+/**
+ * Gets a move from a local player
+ * @param board The tic-tac-toe board
+ * @param cur_player The player whose turn it is
+ * @return The position of the player's move
+ */
+int get_local_move(const board_t *board, int cur_player);
+
+/**
+ * Gets a move from a remote player. Sends the move played on the board since
+ * the remote player last moved, then waits for theirs while the screen keeps
+ * updating. Exits the game if the remote player leaves
+ * @param board The tic-tac-toe board
+ * @param cur_player The player whose turn it is
+ * @return The position of the player's move
+ */
+int get_remote_move(const board_t *board, int cur_player);
+
+/**
+ * Establishes a connection to a remote player, listening for them or
+ * connecting to them as remote_host says, and agrees on who plays which
+ * player. Exits the game if that fails
+ * @param remote_player The player the remote player plays (either 1 or 2)
+ */
+void establish_connection(int remote_player);
+
+/**
+ * Sends the last move and the result of a finished game to the remote
+ * player, waits for their result and shows the round trip times of the
+ * game. Does nothing if there is no remote player
+ * @param board The final tic-tac-toe board
+ * @param result The result of the game (0 if tie, 1/2 if player 1/2 won)
+ */
+void close_connection(const board_t *board, int result);
+
+/**
+ * Sets the difficulty level of a computer opponent
+ * @param player The player number of the bot (either 1 or 2)
+ * @return A pointer to the move function of the corresponding bot difficulty
+ */
+player_move_func set_bot_difficulty(int player);
+
+/**
+ * Performs the main game loop of drawing the board, getting a move, placing a
+ * mark, then switching players
+ * @param g The game struct
+ * @return The final result of the game. 0 for tie, 1/2 for player 1/2 winning
+ */
+int game_loop(game *g);
+
+/**
+ * Prints the current state of the board
+ * @param win The window on which to print the board
+ * @param board The tic-tac-toe board
+ */
+void print_board(const board_t *board);
+
+/**
+ * Prints the current state of an m,n,k board
+ * @param board The board
+ * @param cursor The square to highlight, or -1 for none
+ */
+void print_mnk_board(const mnk_board *board, int cursor);
+
+/**
+ * Gets a move from a local player on an m,n,k board
+ * @param board The board
+ * @param cur_player The player whose turn it is
+ * @return The position of the player's move
+ */
+int get_mnk_local_move(mnk_board *board, int cur_player);
+
+/**
+ * Performs the main game loop on an m,n,k board. Computer players use the
+ * m,n,k bot
+ * @param g The game struct
+ * @param board The board, which must be empty
+ * @return The final result of the game. 0 for tie, 1/2 for player 1/2 winning
+ */
+int mnk_game_loop(game *g, mnk_board *board);
+
+/**
+ * Gets the screen row of the stats below an m,n,k board. The results go 3
+ * rows further down
+ * @param board The board
+ * @return The screen row
+ */
+int mnk_footer_row(const mnk_board *board);
+
+/**
+ * Prints the search counters of the last bot move (see stats.h)
+ * @param player The player whose move was searched
+ * @param row The first of the two screen rows to print on
+ */
+void print_stats(int player, int row);
+
+/**
+ * Prints the results of the game
+ * @param result The final result of the game
+ * @param row The first of the two screen rows to print on
+ */
+void print_results(int result, int row);
+
+#endif
+/* EOF */
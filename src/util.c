@@ -1,273 +1,253 @@
-#include <ncurses.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#ifdef _WIN32
-    #include <Windows.h>
-#else
-    #include <unistd.h>
-#endif
-
 #include "util.h"
 #include "hashtable.h"
+#include "pool.h"
+#include "precache.h"
+#include "stats.h"
+
+typedef int (*root_score_func)(const board_t *, int, int, int);
 
-const char marks[3] = { ' ', 'X', 'O' };
+typedef struct root_job_t root_job;
+
+/* A root move handed to a search pool worker */
+struct root_job_t
+{
+    board_t board;
+    int player_to_move;
+    int player_to_optimize;
+    int depth;
+    root_score_func score_func;
+    int score;
+    search_stats stats;
+};
+
+static int cache_child_score(const board_t *board, int player_to_move,
+                             int player_to_optimize, int depth);
+
+const uint16_t win_masks[8] = {
+    0x007, 0x038, 0x1C0,    /* Rows */
+    0x049, 0x092, 0x124,    /* Columns */
+    0x111, 0x054            /* Back slash and forward slash diagonals */
+};
 
 ht_t *cache = NULL;
 ht_t *fast_cache = NULL;
-
-/* Initializes ncurses */
+ht_t *ab_cache = NULL;
+
+double cache_max_load = HT_DEFAULT_MAX_LOAD;
+int cache_hash = HT_HASH_MULTIPLY_SHIFT;
+
+const player_move_func bot_move_funcs[NUM_BOTS] = {
+    get_easy_bot_move,
+    get_medium_bot_move,
+    get_minimax_bot_move,
+    get_cache_bot_move,
+    get_fastcache_bot_move,
+    get_ab_pruning_bot_move,
+    get_precache_bot_move,
+    get_lazy_smp_bot_move
+};
+
+const char *bot_names[NUM_BOTS] = {
+    "easy",
+    "medium",
+    "minimax",
+    "cache",
+    "fastcache",
+    "ab_pruning",
+    "precache",
+    "lazy_smp"
+};
+
+/* Square i of a transformed board comes from square symmetry_src[t][i] of the
+ * original board. The first four are rotations clockwise by 0, 90, 180 and
+ * 270 degrees, then the mirrors left-right, top-bottom and across both
+ * diagonals */
+static const int symmetry_src[NUM_SYMMETRIES][9] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8 },
+    { 6, 3, 0, 7, 4, 1, 8, 5, 2 },
+    { 8, 7, 6, 5, 4, 3, 2, 1, 0 },
+    { 2, 5, 8, 1, 4, 7, 0, 3, 6 },
+    { 2, 1, 0, 5, 4, 3, 8, 7, 6 },
+    { 6, 7, 8, 3, 4, 5, 0, 1, 2 },
+    { 0, 3, 6, 1, 4, 7, 2, 5, 8 },
+    { 8, 5, 2, 7, 4, 1, 6, 3, 0 }
+};
+
+/* The number of lines through each square. Searches try the center first,
+ * then the corners */
+static const int square_priority[9] = { 3, 2, 3, 2, 4, 2, 3, 2, 3 };
+
+/* symmetry_masks[t][mask] is mask moved through symmetry t */
+static uint16_t symmetry_masks[NUM_SYMMETRIES][FULL_BOARD + 1];
+static pthread_once_t symmetry_masks_once = PTHREAD_ONCE_INIT;
+
+/* Held while a search cache is created on first use */
+static pthread_mutex_t cache_create_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Clears every square of the board */
 void
-init_ncurses(void)
+board_clear(board_t *board)
 {
-    initscr();
-    noecho();
-    cbreak();
-    refresh();
-    curs_set(0);
-    keypad(stdscr, true);
+    board->masks[0] = 0;
+    board->masks[1] = 0;
 }
 
-/* Initializes the game struct */
-void
-init_game(game *g)
+/* Gets the owner of a square on the board */
+int
+board_get(const board_t *board, int pos)
 {
-    srand(time(NULL));
-    g->cur_player = 1;
-    g->turn = 1;
-    memset(g->board, ' ', 9);
+    if (board->masks[0] & (1 << pos)) { return 1; }
+    if (board->masks[1] & (1 << pos)) { return 2; }
 
-    printw("Welcome to Tic-Tac-Toe!");
+    return 0;
 }
 
-/* Sets the player types */
+/* Places a player's mark on the board */
 void
-set_players(int *players)
-{
-    int i, player, key;
-    int highlight = 1, num_opts = 3, widest_str_len = 15;
-    bool should_continue = true;
-    WINDOW *player_select_win;
-    const char *player_options[] = {
-        "Local Player",
-        "Remote Player",
-        "Computer Player"
-    };
-
-    player_select_win = newwin(num_opts + 2, widest_str_len + 2, 3, 0);
-    box(player_select_win, 0, 0);
-    wrefresh(player_select_win);
-    keypad(player_select_win, true);
-
-    for (player = 1; player < 3; player++) {
-        should_continue = true;
-        mvprintw(1, 0, "Choose player %d (%c):", player, marks[player]);
-        refresh();
-
-        /* Sets the player type for player 1 */
-        while (should_continue) {
-            for (i = 1; i <= num_opts; i++) {
-                if (i == highlight) { wattron(player_select_win, A_STANDOUT); }
-                mvwprintw(player_select_win, i, 1, "%s", player_options[i - 1]);
-                wattroff(player_select_win, A_STANDOUT);
-            } /* for */
-            wrefresh(player_select_win);
-            key = wgetch(player_select_win);
-
-            switch (key) {
-                case KEY_UP:
-                case 'w':
-                    highlight--;
-                    if (highlight < 1) { highlight = num_opts; }
-                    break;
-                case KEY_DOWN:
-                case 's':
-                    highlight++;
-                    if (highlight > num_opts) { highlight = 1; }
-                    break;
-                case 10:
-                    players[player - 1] = highlight - 1;
-                    should_continue = false;
-                    break;
-                default:
-                    break;
-            } /* switch */
-        } /* while */
-    } /* for */
+board_place(board_t *board, int pos, int player)
+{
+    board->masks[player - 1] |= 1 << pos;
+}
 
-    delwin(player_select_win);
-    player_select_win = NULL;
-    clear();
-    refresh();
+/* Gets the empty squares of the board */
+uint16_t
+board_empty(const board_t *board)
+{
+    return ~(board->masks[0] | board->masks[1]) & FULL_BOARD;
 }
 
-/* Sets the player move function pointers */
-void 
-set_player_moves(int *players, player_move_func *player_move_funcptr)
+/* Encodes the board as a base-3 number */
+uint32_t
+board_key(const board_t *board)
 {
     int i;
+    uint32_t key = 0;
 
-    for (i = 0; i < 2; i++) {
-        switch (players[i]) {
-            case PLAYER_LOCAL:
-                player_move_funcptr[i] = get_local_move;
-                break;
-            case PLAYER_REMOTE:
-                player_move_funcptr[i] = get_remote_move;
-                establish_connection();
-                break;
-            case PLAYER_COMPUTER:
-                player_move_funcptr[i] = set_bot_difficulty(i + 1);
-                break;
-            default:
-                break;
-        } /* switch */
+    for (i = 8; i >= 0; i--) {
+        key = key * 3 + board_get(board, i);
+    } /* for */
+
+    return key;
+}
+
+/* Fills in the transformed masks for every symmetry of the board */
+static void
+init_symmetry_masks(void)
+{
+    int t, mask, i;
+
+    for (t = 0; t < NUM_SYMMETRIES; t++) {
+        for (mask = 0; mask <= FULL_BOARD; mask++) {
+            symmetry_masks[t][mask] = 0;
+            for (i = 0; i < 9; i++) {
+                if (mask & (1 << symmetry_src[t][i])) {
+                    symmetry_masks[t][mask] |= 1 << i;
+                } /* if */
+            } /* for */
+        } /* for */
+    } /* for */
+}
+
+/* Applies one of the 8 symmetries to the board */
+void
+transform_board(const board_t *board, int transform, board_t *transformed)
+{
+    pthread_once(&symmetry_masks_once, init_symmetry_masks);
+
+    transformed->masks[0] = symmetry_masks[transform][board->masks[0]];
+    transformed->masks[1] = symmetry_masks[transform][board->masks[1]];
+}
+
+/* Gets the key of the canonical form of the board */
+uint32_t
+canonical_key(const board_t *board, int *transform)
+{
+    int t;
+    uint32_t packed, best_packed = UINT32_MAX;
+    board_t transformed, canonical = *board;
+
+    pthread_once(&symmetry_masks_once, init_symmetry_masks);
+
+    /* The canonical board is the one whose masks pack into the smallest
+     * number, which is cheaper to compare than the base-3 keys */
+    for (t = 0; t < NUM_SYMMETRIES; t++) {
+        transformed.masks[0] = symmetry_masks[t][board->masks[0]];
+        transformed.masks[1] = symmetry_masks[t][board->masks[1]];
+        packed = transformed.masks[0] | (uint32_t)transformed.masks[1] << 9;
+        if (packed < best_packed) {
+            best_packed = packed;
+            canonical = transformed;
+            *transform = t;
+        } /* if */
     } /* for */
+
+    return board_key(&canonical);
 }
 
-/* Gets a move from a local player */
+/* Maps a square of the board onto the transformed board */
 int
-get_local_move(const char *board, int cur_player)
+transform_move(int pos, int transform)
 {
-    int i, pos, key;
-    int pos_hi = 0;
-    bool should_continue = true;
+    int i;
 
-    while (should_continue) {
-        for (i = 0; i < 9; i++) {
-            if (i == pos_hi) { attron(A_STANDOUT); }
-            mvprintw(3 + 3 * (i / 3), 3 + 4 * (i % 3), "%c", board[i]);
-            attroff(A_STANDOUT);
-        } /* for */
-        refresh();
-        key = getch();
-
-        switch (key) {
-            case KEY_UP:
-            case 'w':
-                pos_hi -= 3;
-                if (pos_hi < 0) { pos_hi += 9; }
-                break;
-            case KEY_DOWN:
-            case 's':
-                pos_hi += 3;
-                if (pos_hi > 8) { pos_hi -= 9; }
-                break;
-            case KEY_LEFT:
-            case 'a':
-                pos_hi--;
-                if (pos_hi == -1 || pos_hi == 2 || pos_hi == 5) { pos_hi += 3; }
-                break;
-            case KEY_RIGHT:
-            case 'd':
-                pos_hi++;
-                if (pos_hi == 3 || pos_hi == 6 || pos_hi == 9) { pos_hi -= 3; }
-                break;
-            case 10:
-                if (board[pos_hi] == ' ') {
-                    pos = pos_hi;
-                    should_continue = false;
-                }
-                break;
-            default:
-                break;
-        } /* switch */
-    } /* while */
+    for (i = 0; i < 9; i++) {
+        if (symmetry_src[transform][i] == pos) { return i; }
+    } /* for */
 
     return pos;
 }
 
-/* Gets a move from a remote player */
+/* Maps a square of the transformed board back onto the board */
 int
-get_remote_move(const char *board, int cur_player)
+untransform_move(int pos, int transform)
 {
-    return 0;
+    return symmetry_src[transform][pos];
 }
 
-/* Establishes a connection to a remote player */
-void 
-establish_connection(void)
-{
-    return;
-}
-
-/* Sets the difficulty level of a computer opponent */
-player_move_func
-set_bot_difficulty(int player)
-{
-    int i, key;
-    int diff_hi = 0, num_opts = 7, widest_str_len = 38;
-    bool should_continue = true;
-    player_move_func diff_mode;
-    WINDOW *diff_win;
-    const char *difficulty_options[] = {
-        "Easy - (Moves randomly)",
-        "Med  - (Easy but makes winning moves)",
-        "Hard - (Minimax)",
-        "Hard - (Minimax w/ cache)",
-        "Hard - (Minimax w/ fast cache)",
-        "Hard - (Minimax w/ alpha beta pruning)",
-        "Hard - (Precache)"
-    };
-    player_move_func bot_move_funcs[7] = {
-        get_easy_bot_move,
-        get_medium_bot_move,
-        get_minimax_bot_move,
-        get_cache_bot_move,
-        get_fastcache_bot_move,
-        get_ab_pruning_bot_move,
-        get_precache_bot_move
-    };
-
-    diff_win = newwin(num_opts + 2, widest_str_len + 2, 2, 0);
-    box(diff_win, 0, 0);
-    wrefresh(diff_win);
-    keypad(diff_win, true);
-
-    mvprintw(0, 0, "Choose player %d bot difficulty:", player);
-    refresh();
-
-    while (should_continue) {
-        for (i = 0; i < num_opts; i++) {
-            if (i == diff_hi) { wattron(diff_win, A_STANDOUT); }
-            mvwprintw(diff_win, i + 1, 1, "%s", difficulty_options[i]);
-            wattroff(diff_win, A_STANDOUT);
-        } /* for */
-        wrefresh(diff_win);
-        key = wgetch(diff_win);
-
-        switch (key) {
-            case KEY_UP:
-            case 'w':
-                diff_hi--;
-                if (diff_hi < 0) { diff_hi = num_opts - 1; }
-                break;
-            case KEY_DOWN:
-            case 's':
-                diff_hi++;
-                if (diff_hi >= num_opts) { diff_hi = 0; }
-                break;
-            case 10:
-                diff_mode = bot_move_funcs[diff_hi];
-                should_continue = false;
-                break;
-            default:
-                break;
-        } /* switch */
-    } /* while */
+/* Initializes the game struct */
+void
+init_game(game *g)
+{
+    srand(time(NULL));
+    g->cur_player = 1;
+    g->turn = 1;
+    g->show_stats = false;
+    board_clear(&g->board);
+}
 
-    delwin(diff_win);
-    diff_win = NULL;
-    clear();
-    refresh();
+/* Creates an empty search cache */
+static ht_t *
+create_cache(void)
+{
+    ht_t *table = ht_create(CACHE_SIZE, cache_max_load);
 
-    return diff_mode;
+    if (table != NULL) { ht_set_hash(table, cache_hash); }
+
+    return table;
+}
+
+/* Creates a search cache the first time a bot needs it, so that games
+ * without that bot never allocate it */
+static void
+lazy_cache(ht_t **table)
+{
+    if (__atomic_load_n(table, __ATOMIC_ACQUIRE) != NULL) { return; }
+
+    pthread_mutex_lock(&cache_create_lock);
+    if (*table == NULL) {
+        __atomic_store_n(table, create_cache(), __ATOMIC_RELEASE);
+    } /* if */
+    pthread_mutex_unlock(&cache_create_lock);
 }
 
 /* Gets a move from an easy bot (places pieces randomly) */
 int 
-get_easy_bot_move(const char *board, int cur_player)
+get_easy_bot_move(const board_t *board, int cur_player)
 {
     int num_empty = 0;
     int legal_moves[9];
@@ -280,115 +260,147 @@ get_easy_bot_move(const char *board, int cur_player)
 /* Gets a move from a medium bot (places pieces randomly unless winning move is
  * available) */
 int 
-get_medium_bot_move(const char *board, int cur_player)
+get_medium_bot_move(const board_t *board, int cur_player)
 {
-    int i, j, pos;
-    int sum = 0;
-    char mark = marks[cur_player];
-
-    /* Checks the rows for a winning move */
-    for (i = 0; i < 9; i += 3) {
-        for (j = i; j < i + 3; j++) {
-            if (board[j] == ' ') { pos = j; }
-            if (board[j] == mark) { sum++; }
-        } /* for */
-        if (sum == 2) { return pos; }
-        sum = 0;
-    } /* for */
-
-    /* Checks the columns for a winning move */
-    for (i = 0; i < 3; i++) {
-        for (j = i; j < i + 7; j += 3) {
-            if (board[j] == ' ') { pos = j; }
-            if (board[j] == mark)  { sum++; }
-        } /* for */
-        if (sum == 2) { return pos; }
-        sum = 0;
-    } /* for */
-
-    /* Checks the forward slash diagonal for a winning move */
-    for (i = 0; i < 9; i += 4) {
-        if (board[i] == ' ') { pos = i; }
-        if (board[i] == mark) { sum++; }
-    } /* for */
-    if (sum == 2) { return pos; }
-    sum = 0;
-
-    /* Checks the backslash diagonal for a winning move */
-    for (i = 2; i < 7; i += 2) {
-        if (board[i] == ' ') { pos = i; }
-        if (board[i] == mark) { sum++; }
+    int i;
+    uint16_t mine = board->masks[cur_player - 1];
+    uint16_t empty = board_empty(board);
+
+    /* A line is a winning move if we hold two of its squares and the third is
+     * still empty */
+    for (i = 0; i < 8; i++) {
+        if (__builtin_popcount(mine & win_masks[i]) == 2
+         && (empty & win_masks[i]) != 0) {
+            return __builtin_ctz(empty & win_masks[i]);
+        } /* if */
     } /* for */
-    if (sum == 2) { return pos; }
 
     return get_easy_bot_move(board, cur_player);
 }
 
-/* Gets a move from a hard bot (applies the minimax algorithm without any
- * enhancements) */
-int 
-get_minimax_bot_move(const char *board, int cur_player)
+/* Scores one root move on a worker thread */
+static void
+run_root_job(void *arg)
 {
-    int i, index, score, num_empty;
+    root_job *job = arg;
+    int root_ply = job->stats.root_ply;
+
+    stats_reset();
+    stats.root_ply = root_ply;
+    job->score = job->score_func(&job->board, job->player_to_move,
+                                 job->player_to_optimize, job->depth);
+    job->stats = stats;
+}
+
+/* Scores every root move with a search function, farming the moves out to
+ * the search pool when there is one */
+static void
+score_root_moves(const board_t *board, int cur_player,
+                 root_score_func score_func, const int *legal_moves,
+                 int num_empty, int *scores)
+{
+    int i;
     int opponent = cur_player == 1 ? 2 : 1;
-    int best_score = -11; 
-    int legal_moves[9], best_pos[9]; 
-    char mark = marks[cur_player];
-    char new_board[9];
+    pool_t *pool = search_pool();
+    pool_group group = { 0 };
+    root_job jobs[9];
+
+    for (i = 0; i < num_empty; i++) {
+        jobs[i].board = *board;
+        board_place(&jobs[i].board, legal_moves[i], cur_player);
+        jobs[i].player_to_move = opponent;
+        jobs[i].player_to_optimize = cur_player;
+        jobs[i].depth = 9 - num_empty;
+        jobs[i].score_func = score_func;
+        jobs[i].stats.root_ply = stats.root_ply;
+
+        if (pool != NULL) { pool_submit(pool, &group, run_root_job, &jobs[i]); }
+        else {
+            scores[i] = score_func(&jobs[i].board, opponent, cur_player,
+                                   9 - num_empty);
+        } /* else */
+    } /* for */
 
-    strncpy(new_board, board, 9);
+    if (pool == NULL) { return; }
 
-    num_empty = get_legal_moves(board, legal_moves);
+    pool_wait(pool, &group);
 
     for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
-        score = minimax_score(new_board, opponent, cur_player, 9 - num_empty);
-        if (score > best_score) {
+        scores[i] = jobs[i].score;
+        stats_add(&stats, &jobs[i].stats);
+    } /* for */
+}
+
+/* Picks one of the best scoring moves at random */
+static int
+pick_best_move(const int *legal_moves, const int *scores, int num_empty)
+{
+    int i;
+    int index = 0;
+    int best_score = -SCORE_INF;
+    int best_pos[9];
+
+    for (i = 0; i < num_empty; i++) {
+        if (scores[i] > best_score) {
             index = 0;
             best_pos[index] = legal_moves[i];
-            best_score = score;
+            best_score = scores[i];
             index++;
         } /* if */
-        else if (score == best_score) {
+        else if (scores[i] == best_score) {
             best_pos[index] = legal_moves[i];
             index++;
         } /* else if */
-        new_board[legal_moves[i]] = ' ';
     } /* for */
 
     return best_pos[rand() % index];
 }
 
+/* Gets a move from a hard bot (applies the minimax algorithm without any
+ * enhancements) */
+int 
+get_minimax_bot_move(const board_t *board, int cur_player)
+{
+    int num_empty;
+    int legal_moves[9], scores[9];
+
+    num_empty = get_legal_moves(board, legal_moves);
+    score_root_moves(board, cur_player, minimax_score, legal_moves, num_empty,
+                     scores);
+
+    return pick_best_move(legal_moves, scores, num_empty);
+}
+
 /* Gets the minimax score */
 int 
-minimax_score(const char *board, int player_to_move, int player_to_optimize,
+minimax_score(const board_t *board, int player_to_move, int player_to_optimize,
               int depth)
 {
     int i, num_empty, status, score;
     int opponent = player_to_move == 1 ? 2 : 1;
-    int max_score = -10, min_score = 10;
+    int max_score = -SCORE_INF, min_score = SCORE_INF;
     int legal_moves[9];
-    char mark = marks[player_to_move];
-    char new_board[9];
+    board_t new_board;
     
+    STAT_NODE(board);
     depth++;
-    status = check_for_win(board, depth + 1);
+    status = check_for_win(board);
 
     if (status != -1) {
+        STAT_INC(terminals);
         if (status == 0) { return 0; }
-        else if (status == player_to_optimize) { return 10; }
-        else { return -10; }
+        else if (status == player_to_optimize) { return win_score(board); }
+        else { return -win_score(board); }
     } /* if */
 
-    strncpy(new_board, board, 9);
     num_empty = get_legal_moves(board, legal_moves);
 
     for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
-        score = minimax_score(new_board, opponent, player_to_optimize, depth);
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], player_to_move);
+        score = minimax_score(&new_board, opponent, player_to_optimize, depth);
         if (score > max_score) { max_score = score; }
         if (score < min_score) { min_score = score; }
-        new_board[legal_moves[i]] = ' ';
     } /* for */
 
     if (player_to_move == player_to_optimize) { return max_score; }
@@ -397,178 +409,156 @@ minimax_score(const char *board, int player_to_move, int player_to_optimize,
 
 /* Gets the current legal moves and number of legal moves on the board */
 int
-get_legal_moves(const char *board, int *legal_moves)
+get_legal_moves(const board_t *board, int *legal_moves)
 {
-    int i;
     int j = 0;
+    uint16_t empty = board_empty(board);
 
-    for (i = 0; i < 9; i++) {
-        if (board[i] == ' ') {
-            legal_moves[j] = i;
-            j++;
-        } /* if */
-    } /* for */
+    /* Pops the lowest empty square off the mask until none are left */
+    while (empty != 0) {
+        legal_moves[j] = __builtin_ctz(empty);
+        empty &= empty - 1;
+        j++;
+    } /* while */
 
     return j;
 }
 
 /* Gets a move from a hard bot (uses minimax with caching) */
 int 
-get_cache_bot_move(const char *board, int cur_player)
+get_cache_bot_move(const board_t *board, int cur_player)
 {
-    int i, index, score, num_empty, result;
-    int opponent = cur_player == 1 ? 2 : 1;
-    int best_score = -11; 
-    int legal_moves[9], best_pos[9]; 
-    char mark = marks[cur_player];
-    char new_board[9], score_str[4] = { 0 };
-
-    strncpy(new_board, board, 9);
+    int num_empty;
+    int legal_moves[9], scores[9];
 
+    lazy_cache(&cache);
     num_empty = get_legal_moves(board, legal_moves);
+    score_root_moves(board, cur_player, cache_child_score, legal_moves,
+                     num_empty, scores);
 
-    for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
+    return pick_best_move(legal_moves, scores, num_empty);
+}
 
-        /* If the current board has not been added to the cache, get the score
-         * the normal way. If it has been added, simply convert from string to
-         * int */
-        if (ht_get(cache, new_board) == NULL) {
-            score = minimax_cache_score(new_board, opponent, cur_player,
-                                        9 - num_empty);
-            result = score_to_result(score, cur_player, opponent);
-            snprintf(score_str, 4, "%d", result);
-            ht_set(cache, new_board, score_str);
-        } /* if */
-        else {
-            result = atoi(ht_get(cache, new_board));
-            score = result_to_score(result, cur_player, opponent);
-        } /* else */
+/* Gets the score of a board from the cache, or searches and caches it */
+static int
+cache_child_score(const board_t *board, int player_to_move,
+                  int player_to_optimize, int depth)
+{
+    int score, result;
+    bool found = false;
+    entry_t entry;
+
+    found = ht_get(cache, board_key(board), &entry);
+    STAT_INC(probes);
+
+    /* Results are cached from player 1's side rather than as a score, so
+     * that they hold no matter which player is optimizing */
+    if (found) {
+        STAT_INC(hits);
+        return result_to_score(entry.score, player_to_optimize);
+    } /* if */
 
-        if (score > best_score) {
-            index = 0;
-            best_pos[index] = legal_moves[i];
-            best_score = score;
-            index++;
-        } /* if */
-        else if (score == best_score) {
-            best_pos[index] = legal_moves[i];
-            index++;
-        } /* else if */
-        new_board[legal_moves[i]] = ' ';
-        memset(score_str, 0, 4);
-    } /* for */
+    score = minimax_cache_score(board, player_to_move, player_to_optimize,
+                                depth);
+    result = score_to_result(score, player_to_optimize);
+    STAT_INC(stores);
+    ht_set(cache, board_key(board), result, HT_EXACT, HT_NO_MOVE, HT_SOLVED);
 
-    return best_pos[rand() % index];
+    return score;
 }
 
 /* Gets the minimax score (either through cache or recursively) */
 int
-minimax_cache_score(const char *board, int player_to_move,
+minimax_cache_score(const board_t *board, int player_to_move,
                     int player_to_optimize, int depth)
 {
-    int i, num_empty, status, score, result;
+    int i, num_empty, status, score;
     int opponent = player_to_move == 1 ? 2 : 1;
-    int max_score = -10, min_score = 10;
+    int max_score = -SCORE_INF, min_score = SCORE_INF;
     int legal_moves[9];
-    char mark = marks[player_to_move];
-    char new_board[9], score_str[4] = { 0 };
+    board_t new_board;
     
+    STAT_NODE(board);
     depth++;
-    status = check_for_win(board, depth + 1);
+    status = check_for_win(board);
 
     if (status != -1) {
+        STAT_INC(terminals);
         if (status == 0) { return 0; }
-        else if (status == player_to_optimize) { return 10; }
-        else { return -10; }
+        else if (status == player_to_optimize) { return win_score(board); }
+        else { return -win_score(board); }
     } /* if */
 
-    strncpy(new_board, board, 9);
     num_empty = get_legal_moves(board, legal_moves);
 
     for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
-
-        if (ht_get(cache, new_board) == NULL) {
-            score = minimax_cache_score(new_board, opponent, player_to_optimize,
-                                        depth);
-            result = score_to_result(score, player_to_move, opponent);
-            snprintf(score_str, 4, "%d", result);
-            ht_set(cache, new_board, score_str);
-        } /* if */
-        else {
-            result = atoi(ht_get(cache, new_board));
-            score = result_to_score(result, player_to_move, opponent);
-        } /* else */
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], player_to_move);
+        score = cache_child_score(&new_board, opponent, player_to_optimize,
+                                  depth);
 
         if (score > max_score) { max_score = score; }
         if (score < min_score) { min_score = score; }
-        new_board[legal_moves[i]] = ' ';
-        memset(score_str, 0, 4);
     } /* for */
 
     if (player_to_move == player_to_optimize) { return max_score; }
     return min_score;
 }
 
-/* Converts the score of a game into a game result */
+/* Gets the score of a won board for the player who won it */
 int
-score_to_result(int score, int player, int opponent)
+win_score(const board_t *board)
 {
-    if (score == 10) { return player; }
-    else if (score == -10) { return opponent; }
+    return WIN_SCORE + 9 - __builtin_popcount(board->masks[0]
+                                              | board->masks[1]);
+}
 
-    return score;
+/* Converts the score of a game into a game result */
+int
+score_to_result(int score, int player)
+{
+    return player == 1 ? score : -score;
 }
 
 /* Converts the result of a game into a score */
 int
-result_to_score(int result, int player, int opponent)
+result_to_score(int result, int player)
 {
-    if (result == player) { return 10; }
-    else if (result == opponent) { return -10; }
-
-    return result;
+    return player == 1 ? result : -result;
 }
 
 /* Gets a move from a hard bot (uses minimax with better caching for when
  * multiple boards are the same state (ie, rotationally equivalent)) */
 int 
-get_fastcache_bot_move(const char *board, int cur_player)
+get_fastcache_bot_move(const board_t *board, int cur_player)
 {
-    int i, index, score, num_empty, result;
+    int i, score, num_empty, transform;
+    int index = 0;
     int opponent = cur_player == 1 ? 2 : 1;
-    int best_score = -11; 
+    int best_score = -SCORE_INF;
     int legal_moves[9], best_pos[9]; 
-    char mark = marks[cur_player];
-    char new_board[9], r90deg_board[9], r180deg_board[9], r270deg_board[9],
-         score_str[4] = { 0 };
-
-    strncpy(new_board, board, 9);
+    uint32_t key = canonical_key(board, &transform);
+    bool found = false;
+    entry_t entry;
+    board_t new_board;
+
+    lazy_cache(&fast_cache);
+    found = ht_get(fast_cache, key, &entry);
+    STAT_INC(probes);
+
+    /* The cached move is for the canonical board, so map it back onto ours */
+    if (found && entry.move != HT_NO_MOVE) {
+        STAT_INC(hits);
+        return untransform_move(entry.move, transform);
+    } /* if */
 
     num_empty = get_legal_moves(board, legal_moves);
 
     for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
-
-        /* If the current board has not been added to the cache, get the score
-         * the normal way. If it has been added, simply convert from string to
-         * int */
-        if (ht_get(fast_cache, new_board) == NULL) {
-            score = minimax_fastcache_score(new_board, opponent, cur_player,
-                                            9 - num_empty);
-            result = score_to_result(score, cur_player, opponent);
-            snprintf(score_str, 4, "%d", result);
-            rotate_board(new_board, r90deg_board, r180deg_board, r270deg_board);
-            ht_set(fast_cache, new_board, score_str);
-            ht_set(fast_cache, r90deg_board, score_str);
-            ht_set(fast_cache, r180deg_board, score_str);
-            ht_set(fast_cache, r270deg_board, score_str);
-        } /* if */
-        else {
-            result = atoi(ht_get(fast_cache, new_board));
-            score = result_to_score(result, cur_player, opponent);
-        } /* else */
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], cur_player);
+        score = minimax_fastcache_score(&new_board, opponent, cur_player,
+                                        9 - num_empty);
 
         if (score > best_score) {
             index = 0;
@@ -580,313 +570,422 @@ get_fastcache_bot_move(const char *board, int cur_player)
             best_pos[index] = legal_moves[i];
             index++;
         } /* else if */
-        new_board[legal_moves[i]] = ' ';
-        memset(score_str, 0, 4);
     } /* for */
 
-    return best_pos[rand() % index];
+    index = best_pos[rand() % index];
+    STAT_INC(stores);
+    ht_set(fast_cache, key, score_to_result(best_score, cur_player),
+           HT_EXACT, transform_move(index, transform), HT_SOLVED);
+
+    return index;
 }
 
 /* Gets the minimax score */ 
 int
-minimax_fastcache_score(const char *board, int player_to_move,
+minimax_fastcache_score(const board_t *board, int player_to_move,
                         int player_to_optimize, int depth)
 {
-    int i, num_empty, status, score, result;
+    int i, num_empty, status, score, transform;
     int opponent = player_to_move == 1 ? 2 : 1;
-    int max_score = -10, min_score = 10;
+    int max_score = -SCORE_INF, min_score = SCORE_INF, max_pos = 0;
+    int min_pos = 0;
     int legal_moves[9];
-    char mark = marks[player_to_move];
-    char new_board[9], r90deg_board[9], r180deg_board[9], r270deg_board[9],
-         score_str[4] = { 0 };
+    uint32_t key;
+    bool found = false;
+    entry_t entry;
+    board_t new_board;
     
+    STAT_NODE(board);
     depth++;
-    status = check_for_win(board, depth + 1);
+    status = check_for_win(board);
 
     if (status != -1) {
+        STAT_INC(terminals);
         if (status == 0) { return 0; }
-        else if (status == player_to_optimize) { return 10; }
-        else { return -10; }
+        else if (status == player_to_optimize) { return win_score(board); }
+        else { return -win_score(board); }
+    } /* if */
+
+    /* All 8 symmetries of a board share one entry, stored under the
+     * canonical board. Results are cached from player 1's side rather than
+     * as a score, so that they hold no matter which player is optimizing */
+    key = canonical_key(board, &transform);
+    found = ht_get(fast_cache, key, &entry);
+    STAT_INC(probes);
+    if (found) {
+        STAT_INC(hits);
+        return result_to_score(entry.score, player_to_optimize);
     } /* if */
 
-    strncpy(new_board, board, 9);
     num_empty = get_legal_moves(board, legal_moves);
 
     for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
-
-        if (ht_get(fast_cache, new_board) == NULL) {
-            score = minimax_fastcache_score(new_board, opponent, player_to_optimize,
-                                            depth);
-            result = score_to_result(score, player_to_move, opponent);
-            rotate_board(new_board, r90deg_board, r180deg_board, r270deg_board);
-            snprintf(score_str, 4, "%d", result);
-            ht_set(fast_cache, new_board, score_str);
-            ht_set(fast_cache, r90deg_board, score_str);
-            ht_set(fast_cache, r180deg_board, score_str);
-            ht_set(fast_cache, r270deg_board, score_str);
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], player_to_move);
+        score = minimax_fastcache_score(&new_board, opponent,
+                                        player_to_optimize, depth);
+        if (score > max_score) {
+            max_score = score;
+            max_pos = legal_moves[i];
+        } /* if */
+        if (score < min_score) {
+            min_score = score;
+            min_pos = legal_moves[i];
         } /* if */
-        else {
-            result = atoi(ht_get(fast_cache, new_board));
-            score = result_to_score(result, player_to_move, opponent);
-        } /* else */
-
-        if (score > max_score) { max_score = score; }
-        if (score < min_score) { min_score = score; }
-        new_board[legal_moves[i]] = ' ';
-        memset(score_str, 0, 4);
     } /* for */
 
-    if (player_to_move == player_to_optimize) { return max_score; }
-    return min_score;
+    if (player_to_move != player_to_optimize) {
+        max_score = min_score;
+        max_pos = min_pos;
+    } /* if */
+
+    STAT_INC(stores);
+
+    ht_set(fast_cache, key,
+           score_to_result(max_score, player_to_optimize), HT_EXACT,
+           transform_move(max_pos, transform), HT_SOLVED);
+
+    return max_score;
 }
 
-/* Rotates the board into new orientations for caching */
-void
-rotate_board(const char *original_board, char *r90deg_board,
-             char *r180deg_board, char *r270deg_board)
-{
-    r90deg_board[0] = original_board[6];
-    r90deg_board[1] = original_board[3];
-    r90deg_board[2] = original_board[0];
-    r90deg_board[3] = original_board[7];
-    r90deg_board[4] = original_board[4];
-    r90deg_board[5] = original_board[1];
-    r90deg_board[6] = original_board[8];
-    r90deg_board[7] = original_board[5];
-    r90deg_board[8] = original_board[2];
-
-    r180deg_board[0] = original_board[8];
-    r180deg_board[1] = original_board[7];
-    r180deg_board[2] = original_board[6];
-    r180deg_board[3] = original_board[5];
-    r180deg_board[4] = original_board[4];
-    r180deg_board[5] = original_board[3];
-    r180deg_board[6] = original_board[2];
-    r180deg_board[7] = original_board[1];
-    r180deg_board[8] = original_board[0];
-
-    r270deg_board[0] = original_board[2];
-    r270deg_board[1] = original_board[5];
-    r270deg_board[2] = original_board[8];
-    r270deg_board[3] = original_board[1];
-    r270deg_board[4] = original_board[4];
-    r270deg_board[5] = original_board[7];
-    r270deg_board[6] = original_board[0];
-    r270deg_board[7] = original_board[3];
-    r270deg_board[8] = original_board[6];
-}
-
-/* Gets a move from a hard bot */
+/* Gets a move from a hard bot (uses negamax with alpha beta pruning) */
 int 
-get_ab_pruning_bot_move(const char *board, int cur_player)
+get_ab_pruning_bot_move(const board_t *board, int cur_player)
 {
-    int i, index, score, num_empty; 
-    int best_score = -11, alpha = -10, beta = 10;
-    int legal_moves[9], best_pos[9]; 
-    char mark = marks[cur_player];
-    char new_board[9];
-
-    strncpy(new_board, board, 9);
+    int i, num_empty;
+    int opponent = cur_player == 1 ? 2 : 1;
+    int best_score = -SCORE_INF, tt_move = -1;
+    int legal_moves[9], scores[9];
+    bool found = false;
+    entry_t entry;
+    board_t new_board;
+    move_order order;
+
+    lazy_cache(&ab_cache);
+    order_init(&order, square_priority, 9);
     num_empty = get_legal_moves(board, legal_moves);
 
+    found = ht_get(ab_cache, board_key(board), &entry);
+    if (found && entry.move != HT_NO_MOVE) { tt_move = entry.move; }
+    order_moves(&order, legal_moves, num_empty, tt_move, 9 - num_empty,
+                cur_player);
+
+    /* Each move is searched with alpha one below the best score so far, so
+     * that a move tying the best one comes back exact and can be picked,
+     * while worse moves are cut off as soon as they are known to be worse */
     for (i = 0; i < num_empty; i++) {
-        new_board[legal_moves[i]] = mark;
-        score = minimax_ab_score(new_board, 10 - num_empty, alpha, beta, true);
-        if (score > best_score) {
-            index = 0;
-            best_pos[index] = legal_moves[i];
-            best_score = score;
-            index++;
-        } /* if */
-        else if (score == best_score) {
-            best_pos[index] = legal_moves[i];
-            index++;
-        } /* else if */
-        new_board[legal_moves[i]] = ' ';
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], cur_player);
+        scores[i] = -minimax_ab_score(&new_board, opponent, -SCORE_INF,
+                                      -(best_score - 1), &order);
+        if (scores[i] > best_score) { best_score = scores[i]; }
     } /* for */
 
-    return best_pos[0];
+    return pick_best_move(legal_moves, scores, num_empty);
 }
 
+/* Gets the negamax score of the board with alpha beta pruning */
 int
-minimax_ab_score(const char *board, int depth, int alpha, int beta,
-                 bool maximizing_player)
+minimax_ab_score(const board_t *board, int player_to_move, int alpha,
+                 int beta, move_order *order)
 {
-    int i, num_empty, status, eval;
-    int max_eval = -10, min_eval = 10;
+    int i, num_empty, status, score, ply;
+    int opponent = player_to_move == 1 ? 2 : 1;
+    int alpha_orig, best_score = -SCORE_INF, best_move = HT_NO_MOVE;
+    int tt_move = -1, marks;
     int legal_moves[9];
-    char mark = marks[depth % 2 + 1];
-    char new_board[9];
+    uint32_t key = board_key(board);
+    bool found = false;
+    entry_t entry;
+    board_t new_board;
 
-    status = check_for_win(board, depth + 1);
+    STAT_NODE(board);
+    status = check_for_win(board);
 
+    /* Only the player who just moved can have won */
     if (status != -1) {
-        if (status == 0) { return 0; }
-        else if (maximizing_player) { return 10; }
-        else { return -10; }
+        STAT_INC(terminals);
+        return status == 0 ? 0 : -win_score(board);
+    } /* if */
+
+    /* Mate distance pruning: the player to move wins on their next mark at
+     * best, and loses on the opponent's next mark at worst. If the window
+     * lies outside of that, the board cannot change the result above */
+    marks = __builtin_popcount(board->masks[0] | board->masks[1]);
+    if (alpha < -(WIN_SCORE + 7 - marks)) { alpha = -(WIN_SCORE + 7 - marks); }
+    if (beta > WIN_SCORE + 8 - marks) { beta = WIN_SCORE + 8 - marks; }
+    if (alpha >= beta) { return alpha; }
+    alpha_orig = alpha;
+
+    found = ht_get(ab_cache, key, &entry);
+    STAT_INC(probes);
+
+    /* A bound only settles the board if it falls outside the window */
+    if (found) {
+        tt_move = entry.move;
+        if (entry.flag == HT_EXACT
+         || (entry.flag == HT_LOWER && entry.score >= beta)
+         || (entry.flag == HT_UPPER && entry.score <= alpha)) {
+            STAT_INC(hits);
+            return entry.score;
+        } /* if */
     } /* if */
 
-    strncpy(new_board, board, 9);
     num_empty = get_legal_moves(board, legal_moves);
+    ply = 9 - num_empty;
+    order_moves(order, legal_moves, num_empty, tt_move, ply, player_to_move);
 
-    if (maximizing_player) {
-        for (i = 0; i < num_empty; i++) {
-            new_board[legal_moves[i]] = mark;
-            eval = minimax_ab_score(new_board, depth + 1, alpha, beta, false);
-            max_eval = max_eval > eval ? max_eval : eval;
-            alpha = alpha > eval ? alpha : eval;
-            if (beta <= alpha) { break; }
-            new_board[legal_moves[i]] = ' ';
-        } /* for */
-        return max_eval;
-    } /* if */
-    else {
-        for (i = 0; i < num_empty; i++) {
-            new_board[legal_moves[i]] = mark;
-            eval = minimax_ab_score(new_board, depth + 1, alpha, beta, true);
-            min_eval = min_eval < eval ? min_eval : eval;
-            beta = beta < eval ? beta : eval;
-            if (beta <= alpha) { break; }
-            new_board[legal_moves[i]] = ' ';
-        } /* for */
-        return min_eval;
-    } /* else */
+    for (i = 0; i < num_empty; i++) {
+        new_board = *board;
+        board_place(&new_board, legal_moves[i], player_to_move);
+        score = -minimax_ab_score(&new_board, opponent, -beta, -alpha, order);
+
+        if (score > best_score) {
+            best_score = score;
+            best_move = legal_moves[i];
+        } /* if */
+        if (score > alpha) { alpha = score; }
+        if (alpha >= beta) {
+            STAT_INC(cutoffs);
+            order_cutoff(order, legal_moves[i], ply, player_to_move,
+                         num_empty);
+            break;
+        } /* if */
+    } /* for */
+
+    STAT_INC(stores);
+    ht_set(ab_cache, key, best_score,
+           best_score <= alpha_orig ? HT_UPPER
+           : best_score >= beta ? HT_LOWER : HT_EXACT,
+           best_move, HT_SOLVED);
+
+    return best_score;
 }
 
 /* Gets a move from a hard bot (looks up moves from a cache file) */
 int 
-get_precache_bot_move(const char *board, int cur_player)
+get_precache_bot_move(const board_t *board, int cur_player)
 {
-    return 0;
+    int skip;
+    uint16_t moves = precache_lookup(board) & PRECACHE_MOVES_MASK;
+
+    STAT_INC(probes);
+    if (moves == 0) { return get_easy_bot_move(board, cur_player); }
+
+    STAT_INC(hits);
+
+    /* Picks one of the best moves at random, like the other hard bots */
+    for (skip = rand() % __builtin_popcount(moves); skip > 0; skip--) {
+        moves &= moves - 1;
+    } /* for */
+
+    return __builtin_ctz(moves);
 }
 
-/* Performs the main game loop of drawing the board, getting a move, placing a
- * mark, then switching players */
-int 
-game_loop(game *g)
+/* Gets a move from a hard bot (runs the m,n,k engine's Lazy SMP search) */
+int
+get_lazy_smp_bot_move(const board_t *board, int cur_player)
 {
-    int pos;
-    int status = -1;
-    cache = ht_create();
-    fast_cache = ht_create();
-
-    while (status == -1) {
-        mvprintw(0, 0, "Player %d's turn (%c) (turn %d):", g->cur_player,
-                 marks[g->cur_player], g->turn);
-        refresh();
-        print_board(g->board);
-
-        pos = (*g->player_move_funcptr[g->cur_player - 1])(g->board,
-                                                           g->cur_player);
-        g->board[pos] = marks[g->cur_player];
-
-        /* Sleep for a second after bot moves so that the user can see moves
-         * being made. Otherwise, the game just appears finished instantly and
-         * is boring */
-        if (g->players[0] == PLAYER_COMPUTER
-         && g->players[1] == PLAYER_COMPUTER) {
-#ifdef _WIN32
-            Sleep(1000);
-#else
-            sleep(1);
-#endif
+    int pos, best_move, depth_reached;
+    mnk_board mnk;
+
+    mnk_init(&mnk, 3, 3, 3);
+    for (pos = 0; pos < 9; pos++) {
+        if (board_get(board, pos) != 0) {
+            mnk_place(&mnk, pos, board_get(board, pos));
         } /* if */
-        g->cur_player = g->cur_player == 1 ? 2 : 1;
-        g->turn++;
+    } /* for */
 
-        /* Check for victory */
-        /* Can only win after the 5th turn, hence the check */
-        if (g->turn > 5) { status = check_for_win(g->board, g->turn); }
-    } /* while */
+    mnk_search_smp(&mnk, cur_player, mnk_time_budget_ms, &best_move,
+                   &depth_reached);
+
+    return best_move;
+}
+
+/* Scores every legal move of the board with a bot's search */
+int
+get_move_scores(const board_t *board, int cur_player, int bot,
+                int *legal_moves, int *scores)
+{
+    int i, result, num_empty;
+    int opponent = cur_player == 1 ? 2 : 1;
+    uint16_t entry;
+    board_t new_board;
+    move_order order;
+
+    num_empty = get_legal_moves(board, legal_moves);
 
-    print_board(g->board);
+    switch (bot) {
+        case BOT_MINIMAX:
+            score_root_moves(board, cur_player, minimax_score, legal_moves,
+                             num_empty, scores);
+            return num_empty;
+        case BOT_CACHE:
+            lazy_cache(&cache);
+            score_root_moves(board, cur_player, cache_child_score,
+                             legal_moves, num_empty, scores);
+            return num_empty;
+        case BOT_FASTCACHE:
+            lazy_cache(&fast_cache);
+            score_root_moves(board, cur_player, minimax_fastcache_score,
+                             legal_moves, num_empty, scores);
+            return num_empty;
+        case BOT_AB_PRUNING:
+            /* A full window keeps every score exact, not just the best */
+            lazy_cache(&ab_cache);
+            order_init(&order, square_priority, 9);
+            for (i = 0; i < num_empty; i++) {
+                new_board = *board;
+                board_place(&new_board, legal_moves[i], cur_player);
+                scores[i] = -minimax_ab_score(&new_board, opponent,
+                                              -SCORE_INF, SCORE_INF, &order);
+            } /* for */
+            return num_empty;
+        case BOT_PRECACHE:
+            /* The table knows the outcome and the plies left after each move,
+             * which say how many marks the final board has */
+            if (precache_get_table() == NULL) { return -1; }
+            for (i = 0; i < num_empty; i++) {
+                new_board = *board;
+                board_place(&new_board, legal_moves[i], cur_player);
+                entry = precache_lookup(&new_board);
+                result = precache_result(entry);
+                scores[i] = WIN_SCORE + 8 - precache_plies(entry)
+                            - __builtin_popcount(~board_empty(board)
+                                                 & FULL_BOARD);
+                if (result == 0) { scores[i] = 0; }
+                else if (result != cur_player) { scores[i] = -scores[i]; }
+            } /* for */
+            return num_empty;
+        default:
+            return -1;
+    } /* switch */
+}
+
+/* Creates the search caches used by the cache bots */
+void
+init_caches(void)
+{
+    if (cache == NULL) { cache = create_cache(); }
+    if (fast_cache == NULL) { fast_cache = create_cache(); }
+    if (ab_cache == NULL) { ab_cache = create_cache(); }
+}
+
+/* Loads the search caches of the cache bots from their snapshot files */
+void
+load_caches(void)
+{
+    if (cache == NULL) {
+        cache = ht_load(CACHE_SNAPSHOT_PATH, cache_max_load);
+    } /* if */
+    if (fast_cache == NULL) {
+        fast_cache = ht_load(FASTCACHE_SNAPSHOT_PATH, cache_max_load);
+    } /* if */
+}
+
+/* Writes the search caches of the cache bots to their snapshot files */
+int
+save_caches(void)
+{
+    int status = 0;
+
+    if (cache != NULL && ht_save(cache, CACHE_SNAPSHOT_PATH) != 0) {
+        status = -1;
+    } /* if */
+    if (fast_cache != NULL
+     && ht_save(fast_cache, FASTCACHE_SNAPSHOT_PATH) != 0) {
+        status = -1;
+    } /* if */
 
     return status;
 }
 
-/* Prints the current state of the board */
-void 
-print_board(const char *board)
+/* Empties the search caches of the cache bots */
+void
+reset_caches(void)
 {
-    mvprintw( 2, 0, "     |   |   ");
-    mvprintw( 3, 0, "A  %c | %c | %c ", board[0], board[1], board[2]);
-    mvprintw( 4, 0, "  ___|___|___");
-    mvprintw( 5, 0, "     |   |   ");
-    mvprintw( 6, 0, "B  %c | %c | %c ", board[3], board[4], board[5]);
-    mvprintw( 7, 0, "  ___|___|___");
-    mvprintw( 8, 0, "     |   |   ");
-    mvprintw( 9, 0, "C  %c | %c | %c ", board[6], board[7], board[8]);
-    mvprintw(10, 0, "     |   |   ");
-    mvprintw(12, 0, "   1 | 2 | 3 ");
-    refresh();
+    if (cache != NULL) { ht_reset(cache); }
+    if (fast_cache != NULL) { ht_reset(fast_cache); }
+    if (ab_cache != NULL) { ht_reset(ab_cache); }
+}
+
+/* Frees the search caches of the cache bots */
+void
+free_caches(void)
+{
+    ht_destroy(cache);
+    ht_destroy(fast_cache);
+    ht_destroy(ab_cache);
+    cache = NULL;
+    fast_cache = NULL;
+    ab_cache = NULL;
+}
+
+/* Gets a move from the current player, places it and switches players */
+int
+play_turn(game *g)
+{
+    int pos;
+
+    pos = (*g->player_move_funcptr[g->cur_player - 1])(&g->board,
+                                                       g->cur_player);
+    board_place(&g->board, pos, g->cur_player);
+    g->cur_player = g->cur_player == 1 ? 2 : 1;
+    g->turn++;
+
+    /* Check for victory */
+    /* Can only win after the 5th turn, hence the check */
+    if (g->turn > 5) { return check_for_win(&g->board); }
+
+    return -1;
 }
 
 /* Checks the current state of the board for termination. */
 int 
-check_for_win(const char *board, int turn)
+check_for_win(const board_t *board)
 {
     int i;
+    uint16_t x = board->masks[0], o = board->masks[1];
 
-    /* Check the rows for a victor */
-    for (i = 0; i < 9; i += 3) {
-        if (board[i] == board[i + 1] && board[i + 1] == board[i + 2]) {
-            if (board[i] == 'X') { return 1; }
-            else if (board[i] == 'O') { return 2; }
-        } /* if */
-    } /* for */
-
-    /* Check the columns for a victor */
-    for (i = 0; i < 3; i++) {
-        if (board[i] == board[i + 3] && board[i + 3] == board[i + 6]) {
-            if (board[i] == 'X') { return 1; }
-            else if (board[i] == 'O') { return 2; }
-        } /* if */
+    /* Check every row, column and diagonal for a victor */
+    for (i = 0; i < 8; i++) {
+        if ((x & win_masks[i]) == win_masks[i]) { return 1; }
+        if ((o & win_masks[i]) == win_masks[i]) { return 2; }
     } /* for */
 
-    /* Checks the back slash diagonal */
-    if (board[0] == board[4] && board[4] == board[8]) {
-        if (board[4] == 'X') { return 1; }
-        else if (board[4] == 'O') { return 2; }
-    } /* if */
-
-    /* Checks the forward slash diagonal */
-    if (board[6] == board[4] && board[4] == board[2]) {
-        if (board[4] == 'X') { return 1; }
-        else if (board[4] == 'O') { return 2; }
-    } /* if */
-
     /* Checks if the board is full with no winner */
-    if (turn == 10) { return 0; }
+    if ((x | o) == FULL_BOARD) { return 0; }
 
     /* Continues the game */
     return -1;
 }
 
-/* Prints the results of the game */
-void
-print_results(int result)
+/* Gets the bot with the given name, or the only bot whose name starts with
+ * it */
+int
+find_bot(const char *name)
 {
-    switch (result) {
-        case 0:
-            mvprintw(15, 0, "The game is a tie!");
-            break;
-        case 1:
-            mvprintw(15, 0, "Player 1 (X) wins!");
-            break;
-        case 2:
-            mvprintw(15, 0, "Player 2 (O) wins");
-            break;
-        default:
-            mvprintw(15, 0, "How did you play a game that neither won nor "
-                    "tied?");
-            break;
-    } /* switch */
+    int i, found = -1;
 
-    mvprintw(16, 0, "Thanks for playing! Press any key to exit.");
-    refresh();
-    getch();
+    for (i = 0; i < NUM_BOTS; i++) {
+        if (strcmp(name, bot_names[i]) == 0) { return i; }
+        if (strncmp(name, bot_names[i], strlen(name)) == 0) {
+            found = found == -1 ? i : NUM_BOTS;
+        } /* if */
+    } /* for */
+
+    return found == NUM_BOTS ? -1 : found;
+}
 
-    endwin();
+/* Gets the current time in nanoseconds */
+long long
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
+
 /* EOF */
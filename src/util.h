@@ -2,9 +2,45 @@
 #define UTIL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "hashtable.h"
+#include "mnk.h"
+#include "order.h"
+
+/* Bitmask of every square on the board */
+#define FULL_BOARD 0x1FF
+
+/* Rotations and reflections of the square board (the dihedral group D4) */
+#define NUM_SYMMETRIES 8
+
+/* Score of a win that fills the board. A win with fewer marks on the board
+ * scores one more for each mark missing, so that the bots play the fastest
+ * win and the slowest loss. A loss scores the negated win */
+#define WIN_SCORE 10
+
+/* Beats the score of any board */
+#define SCORE_INF (WIN_SCORE + 5)
+
+/* Slots each search cache starts with. A cache doubles whenever it fills
+ * past cache_max_load, so it ends up sized to what its bot searched. A 3x3
+ * game has 5478 legal positions */
+#define CACHE_SIZE 1024
+
+/* Default locations of the cache snapshots, relative to the repo root */
+#define CACHE_SNAPSHOT_PATH "bin/cache.bin"
+#define FASTCACHE_SNAPSHOT_PATH "bin/fastcache.bin"
+
+typedef struct board_t board_t;
 typedef struct game_t game;
-typedef int (*player_move_func)(const char *, int);
+typedef int (*player_move_func)(const board_t *, int);
+
+/* Square i of the board is bit i of a mask, numbered left to right, top to
+ * bottom. masks[0] holds the squares taken by X and masks[1] those taken by O */
+struct board_t
+{
+    uint16_t masks[2];
+};
 
 struct game_t
 {
@@ -12,7 +48,8 @@ struct game_t
     int players[2];
     int cur_player;
     int turn;
-    char board[9];
+    bool show_stats;
+    board_t board;
 };
 
 enum player_types {
@@ -28,60 +65,109 @@ enum bot_difficulty {
     BOT_CACHE,
     BOT_FASTCACHE,
     BOT_AB_PRUNING,
-    BOT_PRECACHE
+    BOT_PRECACHE,
+    BOT_LAZY_SMP,
+    NUM_BOTS
 };
 
+/* The caches of the cache and fastcache bots. Created by init_caches */
+extern ht_t *cache;
+extern ht_t *fast_cache;
+extern ht_t *ab_cache;
+
+/* The load factor the search caches grow at. Set it before the caches are
+ * created */
+extern double cache_max_load;
+
+/* The hash function of the search caches (one of ht_hashes). Set it before
+ * the caches are created */
+extern int cache_hash;
+
+/* The move function and short name of each bot, indexed by bot_difficulty */
+extern const player_move_func bot_move_funcs[NUM_BOTS];
+extern const char *bot_names[NUM_BOTS];
+
+/* The masks of the 8 winning lines (3 rows, 3 columns, 2 diagonals) */
+extern const uint16_t win_masks[8];
+
 /**
- * Initializes ncurses
+ * Clears every square of the board
+ * @param board The tic-tac-toe board
  */
-void init_ncurses(void);
+void board_clear(board_t *board);
 
 /**
- * Initializes the game struct
- * @param g The game struct
+ * Gets the owner of a square on the board
+ * @param board The tic-tac-toe board
+ * @param pos The position of the square (0-8)
+ * @return 0 if the square is empty, 1/2 if player 1/2 owns it
  */
-void init_game(game *g);
+int board_get(const board_t *board, int pos);
 
 /**
- * Sets the player types
- * @param players An array containing the chosen player types
+ * Places a player's mark on the board
+ * @param board The tic-tac-toe board
+ * @param pos The position of the square (0-8)
+ * @param player The player whose mark is placed
  */
-void set_players(int *players);
+void board_place(board_t *board, int pos, int player);
 
 /**
- * Sets the player move function pointers
- * @param players An array containing the chosen player types
- * @param player_move_funcptr An array containing the player move functions
+ * Gets the empty squares of the board
+ * @param board The tic-tac-toe board
+ * @return A mask with bit i set if square i is empty
  */
-void set_player_moves(int *players, player_move_func *player_move_funcptr);
+uint16_t board_empty(const board_t *board);
 
 /**
- * Gets a move from a local player
+ * Encodes the board as a base-3 number, for use as a hashtable key. Square i
+ * is digit i, which is 0 if the square is empty or 1/2 if player 1/2 owns it
  * @param board The tic-tac-toe board
- * @param cur_player The player whose turn it is
- * @return The position of the player's move
+ * @return The key of the board, between 0 and 3^9 - 1
  */
-int get_local_move(const char *board, int cur_player);
+uint32_t board_key(const board_t *board);
 
 /**
- * Gets a move from a remote player
+ * Applies one of the 8 symmetries (rotations and reflections) to the board
  * @param board The tic-tac-toe board
- * @param cur_player The player whose turn it is
- * @return The position of the player's move
+ * @param transform The symmetry to apply (0 to NUM_SYMMETRIES - 1). 0 leaves
+ * the board unchanged
+ * @param transformed The transformed board. Passed in as an out value
  */
-int get_remote_move(const char *board, int cur_player);
+void transform_board(const board_t *board, int transform,
+                     board_t *transformed);
 
 /**
- * Establishes a connection to a remote player
+ * Gets the key of the canonical form of the board, which is the same for the
+ * board and all of its rotations and reflections
+ * @param board The tic-tac-toe board
+ * @param transform The symmetry that maps the board onto its canonical form.
+ * Passed in as an out value
+ * @return The base-3 key of the canonical board
  */
-void establish_connection(void);
+uint32_t canonical_key(const board_t *board, int *transform);
 
 /**
- * Sets the difficulty level of a computer opponent
- * @param player The player number of the bot (either 1 or 2)
- * @return A pointer to the move function of the corresponding bot difficulty
+ * Maps a square of the board onto the board after a symmetry is applied
+ * @param pos The position of the square (0-8)
+ * @param transform The applied symmetry
+ * @return The position of the square on the transformed board
  */
-player_move_func set_bot_difficulty(int player);
+int transform_move(int pos, int transform);
+
+/**
+ * Maps a square of a transformed board back onto the original board
+ * @param pos The position of the square on the transformed board (0-8)
+ * @param transform The symmetry that was applied
+ * @return The position of the square on the original board
+ */
+int untransform_move(int pos, int transform);
+
+/**
+ * Initializes the game struct
+ * @param g The game struct
+ */
+void init_game(game *g);
 
 /**
  * Gets a move from an easy bot (places pieces randomly)
@@ -89,7 +175,7 @@ player_move_func set_bot_difficulty(int player);
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_easy_bot_move(const char *board, int cur_player);
+int get_easy_bot_move(const board_t *board, int cur_player);
 
 /**
  * Gets a move from a medium bot (places pieces randomly unless winning move is
@@ -98,7 +184,7 @@ int get_easy_bot_move(const char *board, int cur_player);
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_medium_bot_move(const char *board, int cur_player);
+int get_medium_bot_move(const board_t *board, int cur_player);
 
 /**
  * Gets a move from a hard bot (applies the minimax algorithm without any
@@ -107,7 +193,7 @@ int get_medium_bot_move(const char *board, int cur_player);
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_minimax_bot_move(const char *board, int cur_player);
+int get_minimax_bot_move(const board_t *board, int cur_player);
 
 /**
  * Gets the score of a potential move on the board
@@ -115,24 +201,25 @@ int get_minimax_bot_move(const char *board, int cur_player);
  * @param player_to_move The player whose turn it is
  * @param player_to_optimize The player whose score we want to maximize
  * @param depth The number of turns that have already been made
- * @return For a terminal state, returns 0 for tie, +10 if the player to move is
- * the player to optimize, -10 otherwise. If the board is not terminal, return
- * the best score from the states below if the player to move is the player to
- * optimize, otherwise return the worst score.
+ * @return For a terminal state, returns 0 for tie, the win score if the player
+ * to move is the player to optimize, its negation otherwise. If the board is
+ * not terminal, return the best score from the states below if the player
+ * to move is the player to optimize, otherwise return the worst score.
  */
-int minimax_score(const char *board, int player_to_move, int player_to_optimize,
-                  int depth);
+int minimax_score(const board_t *board, int player_to_move,
+                  int player_to_optimize, int depth);
 
 /**
  * Gets all of the legal moves on the board.
- * @note The legal moves array contains the positions of legal moves. eg, only
- * one legal move would be [pos, garbage, ..., -1]
+ * @note The legal moves array contains the positions of legal moves in
+ * ascending order. Only the first n entries are written, where n is the
+ * returned number of legal moves
  * @param board The tic-tac-toe board
- * @param legal_moves An array of the positions of legal moves. Passed in as an
- * out value. Illegal moves are -1, which the board is initialized to
+ * @param legal_moves An array of at least 9 ints for the positions of legal
+ * moves. Passed in as an out value
  * @return The number of legal moves for the board
  */
-int get_legal_moves(const char *board, int *legal_moves);
+int get_legal_moves(const board_t *board, int *legal_moves);
 
 /**
  * Gets a move from a hard bot (uses minimax with caching)
@@ -140,7 +227,7 @@ int get_legal_moves(const char *board, int *legal_moves);
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_cache_bot_move(const char *board, int cur_player);
+int get_cache_bot_move(const board_t *board, int cur_player);
 
 /**
  * Gets the score of a potential move on the board, either from a hashtable if
@@ -150,87 +237,88 @@ int get_cache_bot_move(const char *board, int cur_player);
  * @param player_to_move The player whose turn it is
  * @param player_to_optimize The player whose score we want to maximize
  * @param depth The number of turns that have already been made
- * @return The result of the board. 0 if tie, -10 if the opponent won, +10 if
- * the player to optimize won
+ * @return The result of the board. 0 if tie, a win score if the player to
+ * optimize won, or its negation if the opponent won
  */
-int minimax_cache_score(const char *board, int player_to_move,
+int minimax_cache_score(const board_t *board, int player_to_move,
                         int player_to_optimize, int depth);
 
 /**
- * Converts a game score into an end game result
- * @param score The score to convert
- * @param player The current player
- * @param opponent The opponent player
- * @return The result of the game. 0 if tie, 1/2 if player 1/2 wins
+ * Gets the score of a won board for the player who won it
+ * @param board The won tic-tac-toe board
+ * @return WIN_SCORE plus the number of empty squares
  */
-int score_to_result(int score, int player, int opponent);
+int win_score(const board_t *board);
 
 /**
- * Converts an end game result into a game score
+ * Converts a game score into a result, which is the same score from player
+ * 1's side and so holds no matter which player is optimizing. The caches
+ * store results. Scores count the marks of the final board rather than the
+ * plies from the searched board, so a result holds at any depth too
  * @param score The score to convert
- * @param player The current player
- * @param opponent The opponent player
- * @return The score of the game. -10 if the opponent won, 0 if tie, +10 if the
- * player to optimize won
+ * @param player The player the score is for
+ * @return The result of the game
  */
-int result_to_score(int result, int player, int opponent);
+int score_to_result(int score, int player);
+
+/**
+ * Converts a result back into a game score
+ * @param result The result to convert
+ * @param player The player the score is for
+ * @return The score of the game for the player
+ */
+int result_to_score(int result, int player);
 
 /**
  * Gets a move from a hard bot (uses minimax with better caching for when
- * multiple boards are the same state (ie, rotationally equivalent))
+ * multiple boards are the same state (ie, rotationally equivalent)). If the
+ * board is already cached, its best move is returned without searching
  * @param board The tic-tac-toe board
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_fastcache_bot_move(const char *board, int cur_player);
+int get_fastcache_bot_move(const board_t *board, int cur_player);
 
 /**
  * Gets the score of a potential move on the board, either from a hash table if
  * the board has been cached or recursive searching if it has not yet been
- * hashed. Also caches rotations of the board since a board and all of its
- * rotations share the same score
+ * hashed. Boards are cached under their canonical form since a board and all
+ * of its rotations and reflections share the same score
  * @param board The tic-tac-toe board
  * @param player_to_move The player whose turn it is
  * @param player_to_optimize The player whose score we want to maximize
  * @param depth The number of turns that have already been made
- * @return The result of the board. 0 if tie, -10 if the opponent won, +10 if
- * the player to optimize won
+ * @return The result of the board. 0 if tie, a win score if the player to
+ * optimize won, or its negation if the opponent won
  */
-int minimax_fastcache_score(const char *board, int player_to_move,
+int minimax_fastcache_score(const board_t *board, int player_to_move,
                             int player_to_optimize, int depth);
 
 /**
- * Rotates the board clockwise to get new orientations for caching.
- * @param original_board The original, unaltered board
- * @param r90deg_board The original board rotated 90 degrees clockwise
- * @param r180deg_board The original board rotated 180 degrees clockwise
- * @param r270deg_board The original board rotated 270 degrees clockwise
- */
-void rotate_board(const char *original_board, char *r90deg_board,
-                  char *r180deg_board, char *r270deg_board);
-
-/**
- * Gets a move from a hard bot (uses fastcache with alpha beta pruning)
+ * Gets a move from a hard bot (uses negamax with alpha beta pruning and a
+ * cache of bounds)
  * @param board The tic-tac-toe board
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_ab_pruning_bot_move(const char *board, int cur_player);
+int get_ab_pruning_bot_move(const board_t *board, int cur_player);
 
 /**
- * Gets the score of a potential move on the board while using alpha beta
- * pruning.
+ * Gets the negamax score of the board with alpha beta pruning. Results are
+ * cached in ab_cache as exact scores or as lower or upper bounds, depending on
+ * whether the search was cut off, so that only the ones that still decide
+ * something under a later window are reused
  * @param board The tic-tac-toe board
- * @param depth The depth at which we are searching
- * @param alpha TODO I think this is the highest score reached so far
- * @param beta TODO I think this is the lowest score reached so far
- * @param maximizing_player Whether or not we are maximizing the score for the
- * current depth (and therefore current player)
- * @return The score of a position. 0 if tie, -10 if the opponent wins, +10 if
- * the current player wins
+ * @param player_to_move The player whose turn it is on the board
+ * @param alpha The score the player to move is already sure of elsewhere
+ * @param beta The score the opponent is already sure of elsewhere, negated
+ * @param order The move ordering state of the search
+ * @return The score of the board for the player to move (0 if tie, a win
+ * score if they win, its negation if they lose) when it is inside the window.
+ * Otherwise a bound on the score: at most alpha, or at least beta
  */
-int minimax_ab_score(const char *board, int depth, int alpha, int beta,
-                     bool maximizing_player);
+int minimax_ab_score(const board_t *board, int player_to_move, int alpha,
+                     int beta, move_order *order);
 
 /**
  * Gets a move from a hard bot (looks up moves from a cache file)
@@ -238,37 +326,98 @@ int minimax_ab_score(const char *board, int depth, int alpha, int beta,
  * @param cur_player The player whose turn it is
  * @return The position of the bot's move
  */
-int get_precache_bot_move(const char *board, int cur_player);
+int get_precache_bot_move(const board_t *board, int cur_player);
 
 /**
- * Performs the main game loop of drawing the board, getting a move, placing a
- * mark, then switching players
- * @param g The game struct
- * @return The final result of the game. 0 for tie, 1/2 for player 1/2 winning
+ * Gets a move from a hard bot (runs the m,n,k engine's Lazy SMP search, with
+ * every search thread sharing one lock-free table)
+ * @param board The tic-tac-toe board
+ * @param cur_player The player whose turn it is
+ * @return The position of the bot's move
  */
-int game_loop(game *g);
+int get_lazy_smp_bot_move(const board_t *board, int cur_player);
 
 /**
- * Prints the current state of the board
- * @param win The window on which to print the board
- * @param board The tic-tac-toe board
+ * Scores every legal move of the board with a bot's search, for analysis
+ * rather than play. The scores are exact, so every move with the best score
+ * is a best move
+ * @param board The tic-tac-toe board, which must not be finished
+ * @param cur_player The player whose turn it is
+ * @param bot The bot_difficulty of the search. Only the minimax, cache,
+ * fastcache, alpha-beta and precache bots score moves
+ * @param legal_moves An array of at least 9 ints for the positions of legal
+ * moves, as get_legal_moves fills it in. Passed in as an out value
+ * @param scores An array of at least 9 ints for the score of each legal move
+ * for the current player (0 if tie, a win score if they win, its negation if
+ * they lose). Passed in as an out value
+ * @return The number of legal moves, or -1 if the bot does not score moves
+ * or the precache table could not be solved for lack of memory
+ */
+int get_move_scores(const board_t *board, int cur_player, int bot,
+                    int *legal_moves, int *scores);
+
+/**
+ * Creates the search caches used by the cache bots, if they do not exist yet.
+ * The bots also create their own cache on first use, but a caller that runs
+ * many bots on many threads at once saves them the lock
+ */
+void init_caches(void);
+
+/**
+ * Loads the search caches of the cache bots from their snapshot files, so
+ * that the bots start warm. Caches that already exist or have no valid
+ * snapshot are left alone
  */
-void print_board(const char *board);
+void load_caches(void);
+
+/**
+ * Writes the search caches of the cache bots to their snapshot files. Caches
+ * that were never created are skipped
+ * @return 0 on success, -1 if a file could not be written
+ */
+int save_caches(void);
+
+/**
+ * Empties the search caches of the cache bots in O(1), so that the next game
+ * starts cold. No bot may be searching meanwhile
+ */
+void reset_caches(void);
+
+/**
+ * Frees the search caches of the cache bots
+ */
+void free_caches(void);
+
+/**
+ * Gets a move from the current player, places it and switches players
+ * @param g The game struct
+ * @return The result of the game after the move. -1 if it continues, 0 for
+ * tie, 1/2 for player 1/2 winning
+ */
+int play_turn(game *g);
 
 /**
  * Checks the current state of the board for termination.
  * @param board The tic-tac-toe board
- * @param cur_player The player who just moved
  * @return The termination state of the game. -1 if the game should continue, 0
  * if the game is tied, 1/2 if player 1/2 won
  */
-int check_for_win(const char *board, int cur_player);
+int check_for_win(const board_t *board);
+
+/**
+ * Looks up a bot by name
+ * @param name The bot's name as in bot_names, or the start of exactly one
+ * bot's name
+ * @return The bot (one of bot_difficulty), or -1 if no bot or more than one
+ * matches
+ */
+int find_bot(const char *name);
 
 /**
- * Prints the results of the game
- * @param result The final result of the game
+ * Gets the time on the monotonic clock, for measuring how long things take
+ * @return The time in nanoseconds
  */
-void print_results(int result);
+long long now_ns(void);
 
 #endif
 /* EOF */